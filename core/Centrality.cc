@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "core/Centrality.h"
+#include "core/Random.h"
+
+using namespace SAGA;
+
+void VariableGraph::build(Minisat::Solver &solver, std::size_t max_clause_size)
+{
+    Minisat::ClauseAllocator &ca = solver.getCa();
+    Minisat::vec<Minisat::CRef> &clauses = solver.getOriginalclauses();
+    const std::size_t n = solver.nVars() + 1;
+
+    // Count the neighbors of every vertex, repeated ones included, then fill the rows
+    occurrence_counts.assign(n, 0);
+    offsets.assign(n + 1, 0);
+    for (int c = 0; c < clauses.size(); ++c)
+    {
+        Minisat::Clause &clause = ca[clauses[c]];
+        bool edges = (std::size_t)clause.size() <= max_clause_size;
+        for (int j = 0; j < clause.size(); ++j)
+        {
+            occurrence_counts[Minisat::var(clause[j]) + 1]++;
+            if (edges)
+                offsets[Minisat::var(clause[j]) + 2] += clause.size() - 1;
+        }
+    }
+    for (std::size_t v = 1; v <= n; ++v)
+        offsets[v] += offsets[v - 1];
+
+    neighbors.resize(offsets[n]);
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (int c = 0; c < clauses.size(); ++c)
+    {
+        Minisat::Clause &clause = ca[clauses[c]];
+        if ((std::size_t)clause.size() > max_clause_size)
+            continue;
+        for (int j = 0; j < clause.size(); ++j)
+        {
+            uint32_t v = Minisat::var(clause[j]) + 1;
+            for (int k = 0; k < clause.size(); ++k)
+                if (k != j)
+                    neighbors[fill[v]++] = Minisat::var(clause[k]) + 1;
+        }
+    }
+
+    // Sort the rows and drop the repeated neighbors, compacting the rows in place
+    std::size_t out = 0;
+    for (std::size_t v = 0, first = offsets[0]; v < n; ++v)
+    {
+        std::size_t last = offsets[v + 1];
+        std::sort(neighbors.begin() + first, neighbors.begin() + last);
+        offsets[v] = out;
+        for (std::size_t i = first; i < last; ++i)
+            if ((i == first || neighbors[i] != neighbors[i - 1]) && neighbors[i] != v)
+                neighbors[out++] = neighbors[i];
+        first = last;
+    }
+    offsets[n] = out;
+    neighbors.resize(out);
+    neighbors.shrink_to_fit();
+}
+
+void Centrality::parallel(std::size_t n, const std::function<void(std::size_t)> &body) const
+{
+    if (pool)
+        pool->parallel_for(n, body);
+    else
+        for (std::size_t t = 0; t < n; ++t)
+            body(t);
+}
+
+std::vector<double> Centrality::scores(int measure, std::size_t samples) const
+{
+    std::vector<double> score(graph.size(), 0);
+    switch (measure)
+    {
+    case CENTRALITY_DEGREE:
+        for (std::size_t v = 1; v < graph.size(); ++v)
+            score[v] = graph.degree(v);
+        return score;
+    case CENTRALITY_BETWEENNESS:
+        return betweenness(samples, 0);
+    case CENTRALITY_PAGERANK:
+        return pagerank();
+    default:
+        for (std::size_t v = 1; v < graph.size(); ++v)
+            score[v] = graph.occurrences(v);
+        return score;
+    }
+}
+
+// Brandes' algorithm restricted to a sample of the sources, scaled to estimate the sum over all of
+// them. Every task runs the BFS of its share of the sources into its own partial sums.
+std::vector<double> Centrality::betweenness(std::size_t samples, uint64_t seed) const
+{
+    const std::size_t n = graph.size();
+    std::vector<double> score(n, 0);
+    if (n <= 2)
+        return score;
+
+    std::vector<uint32_t> sources;
+    if (samples >= n - 1)
+    {
+        for (std::size_t v = 1; v < n; ++v)
+            sources.push_back(v);
+    }
+    else
+    {
+        Xoshiro256 rng(seed);
+        std::uniform_int_distribution<uint32_t> pick(1, n - 1);
+        for (std::size_t s = 0; s < samples; ++s)
+            sources.push_back(pick(rng));
+    }
+
+    std::size_t ntasks = std::min<std::size_t>(pool ? pool->size() : 1, sources.size());
+    std::vector<std::vector<double>> partial(ntasks);
+    parallel(ntasks, [&](std::size_t t)
+             {
+                 std::vector<double> &sum = partial[t];
+                 sum.assign(n, 0);
+                 std::vector<int> dist(n, -1);
+                 std::vector<double> sigma(n, 0); // Number of shortest paths from the source.
+                 std::vector<double> delta(n, 0); // Dependency of the source on each vertex.
+                 std::vector<uint32_t> order;     // Vertices in BFS order, i.e. by distance.
+                 order.reserve(n);
+                 for (std::size_t s = t; s < sources.size(); s += ntasks)
+                 {
+                     uint32_t source = sources[s];
+                     order.clear();
+                     order.push_back(source);
+                     dist[source] = 0;
+                     sigma[source] = 1;
+                     for (std::size_t head = 0; head < order.size(); ++head)
+                     {
+                         uint32_t v = order[head];
+                         for (const uint32_t *w = graph.begin(v); w != graph.end(v); ++w)
+                         {
+                             if (dist[*w] < 0)
+                             {
+                                 dist[*w] = dist[v] + 1;
+                                 order.push_back(*w);
+                             }
+                             if (dist[*w] == dist[v] + 1)
+                                 sigma[*w] += sigma[v];
+                         }
+                     }
+                     for (std::size_t i = order.size(); i-- > 0;)
+                     {
+                         uint32_t v = order[i];
+                         for (const uint32_t *w = graph.begin(v); w != graph.end(v); ++w)
+                             if (dist[*w] == dist[v] + 1)
+                                 delta[v] += sigma[v] / sigma[*w] * (1 + delta[*w]);
+                         if (v != source)
+                             sum[v] += delta[v];
+                     }
+                     for (uint32_t v : order)
+                     {
+                         dist[v] = -1;
+                         sigma[v] = 0;
+                         delta[v] = 0;
+                     }
+                 } });
+
+    double scale = (double)(n - 1) / sources.size();
+    for (std::size_t t = 0; t < ntasks; ++t)
+        for (std::size_t v = 0; v < n; ++v)
+            score[v] += partial[t][v] * scale;
+    return score;
+}
+
+// Power iteration over the undirected graph, the rank of the vertices without neighbors being spread
+// over all vertices. The vertices are split in fixed blocks so that the sums do not depend on the pool.
+std::vector<double> Centrality::pagerank(double damping, int max_iterations, double tolerance) const
+{
+    const std::size_t n = graph.size();
+    std::vector<double> rank(n, 0);
+    if (n <= 1)
+        return rank;
+
+    const std::size_t block = 4096;
+    const std::size_t nblocks = (n + block - 1) / block;
+    const double nvertices = n - 1;
+    std::vector<double> share(n, 0); // rank / degree of each vertex.
+    std::vector<double> next(n, 0);
+    std::vector<double> change(nblocks);
+    std::fill(rank.begin() + 1, rank.end(), 1 / nvertices);
+
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        double dangling = 0;
+        for (std::size_t v = 1; v < n; ++v)
+        {
+            if (graph.degree(v) == 0)
+                dangling += rank[v];
+            else
+                share[v] = rank[v] / graph.degree(v);
+        }
+        double base = (1 - damping + damping * dangling) / nvertices;
+
+        parallel(nblocks, [&](std::size_t b)
+                 {
+                     change[b] = 0;
+                     for (std::size_t v = std::max<std::size_t>(1, b * block); v < std::min(n, (b + 1) * block); ++v)
+                     {
+                         double sum = 0;
+                         for (const uint32_t *u = graph.begin(v); u != graph.end(v); ++u)
+                             sum += share[*u];
+                         next[v] = base + damping * sum;
+                         change[b] += std::fabs(next[v] - rank[v]);
+                     } });
+
+        rank.swap(next);
+        double total = 0;
+        for (double c : change)
+            total += c;
+        if (total < tolerance)
+            break;
+    }
+    return rank;
+}
+
+std::vector<unsigned> Centrality::top(const std::vector<double> &score, std::size_t k) const
+{
+    std::vector<unsigned> vertices;
+    for (std::size_t v = 1; v < score.size(); ++v)
+        vertices.push_back(v);
+    k = std::min(k, vertices.size());
+    std::partial_sort(vertices.begin(), vertices.begin() + k, vertices.end(), [&score](unsigned a, unsigned b)
+                      { return score[a] > score[b] || (score[a] == score[b] && a < b); });
+    vertices.resize(k);
+    return vertices;
+}
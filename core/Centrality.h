@@ -0,0 +1,75 @@
+#ifndef _CENTRALITY_H_
+#define _CENTRALITY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "core/Solver.h"
+#include "core/ThreadPool.h"
+
+namespace SAGA
+{
+
+    // Variable incidence graph of the clauses of a solver, in compressed sparse row form. Vertex v is
+    // solver variable v - 1 (vertex 0 is unused, as in Formula), and two vertices are adjacent iff their
+    // variables share a clause. Clauses longer than 'max_clause_size' only count as occurrences: their
+    // cliques would dominate both the size of the graph and the centrality of their variables.
+    class VariableGraph
+    {
+    public:
+        VariableGraph() : offsets(1, 0) {}
+
+        void build(Minisat::Solver &solver, std::size_t max_clause_size = 64);
+
+        std::size_t size() const { return offsets.size() - 1; }
+        std::size_t degree(std::size_t v) const { return offsets[v + 1] - offsets[v]; }
+        const uint32_t *begin(std::size_t v) const { return neighbors.data() + offsets[v]; }
+        const uint32_t *end(std::size_t v) const { return neighbors.data() + offsets[v + 1]; }
+        // Number of clauses the variable of vertex v occurs in, long ones included
+        uint32_t occurrences(std::size_t v) const { return occurrence_counts[v]; }
+
+    private:
+        // Neighbors of v are neighbors[offsets[v] .. offsets[v + 1]). Before the duplicates are removed
+        // the rows hold every clique edge, which may well exceed 2^32 entries.
+        std::vector<std::size_t> offsets;
+        std::vector<uint32_t> neighbors; // Sorted and without duplicates within a vertex.
+        std::vector<uint32_t> occurrence_counts;
+    };
+
+    // Centrality of the vertices of a VariableGraph, the higher the more central. The measures are
+    // spread over the threads of 'pool' (sequential when null).
+    class Centrality
+    {
+    public:
+        enum Measure
+        {
+            CENTRALITY_OCCURRENCES, // Number of clauses of the variable.
+            CENTRALITY_DEGREE,      // Number of variables it shares a clause with.
+            CENTRALITY_BETWEENNESS, // Shortest paths through it, estimated from sampled sources (Brandes).
+            CENTRALITY_PAGERANK
+        };
+
+        Centrality(const VariableGraph &graph_, ThreadPool *pool_) : graph(graph_), pool(pool_) {}
+
+        // Scores of a Measure, the betweenness being estimated from 'samples' sources
+        std::vector<double> scores(int measure, std::size_t samples) const;
+        // Betweenness estimate from 'samples' BFS sources drawn with 'seed' (exact when samples >= size() - 1)
+        std::vector<double> betweenness(std::size_t samples, uint64_t seed) const;
+        std::vector<double> pagerank(double damping = 0.85, int max_iterations = 100, double tolerance = 1e-9) const;
+
+        // The k vertices of highest score, best first (ties go to the lower vertex), vertex 0 excluded
+        std::vector<unsigned> top(const std::vector<double> &score, std::size_t k) const;
+
+    private:
+        // Run body(t) for t in [0, n) on the pool
+        void parallel(std::size_t n, const std::function<void(std::size_t)> &body) const;
+
+        const VariableGraph &graph;
+        ThreadPool *pool;
+    };
+
+}
+
+#endif // _CENTRALITY_H_
@@ -29,21 +29,6 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 
 namespace Minisat
 {
-    std::vector<unsigned> get_sorted_variables_by_occurrence(std::vector<unsigned> &vars_occ_cnt)
-    {
-        // Create a vector of variables
-        size_t num_vars_to_keep = vars_occ_cnt.size() * 0.1;
-        std::vector<unsigned> variables(vars_occ_cnt.size());
-        for (int i = 0; i < variables.size(); ++i)
-            variables[i] = i;
-
-        // Sort the variables based on the number of clauses they appear in
-        std::sort(variables.begin(), variables.end(), [&vars_occ_cnt](int a, int b)
-                  { return vars_occ_cnt[a] > vars_occ_cnt[b]; });
-
-        std::vector<unsigned> variables_to_keep(variables.begin(), variables.begin() + num_vars_to_keep);
-        return variables;
-    }
 
     //=================================================================================================
     // DIMACS Parser:
@@ -108,34 +93,31 @@ namespace Minisat
     }
 
     template <class B, class Solver>
-    static void readClause(B &in, Solver &S, vec<Lit> &lits, SAGA::Formula &formula, std::vector<unsigned> &vars_occ_cnt)
+    static void readClause(B &in, Solver &S, vec<Lit> &lits, SAGA::Formula &formula)
     {
-        int parsed_lit, var;
         lits.clear();
 
         for (;;)
         {
-            parsed_lit = parseInt(in);
+            int parsed_lit = parseInt(in);
             if (parsed_lit == 0)
                 break;
-            var = abs(parsed_lit) - 1;
+            int var = abs(parsed_lit) - 1;
             while (var >= S.nVars())
                 S.newVar();
             lits.push((parsed_lit > 0) ? mkLit(var) : ~mkLit(var));
-            vars_occ_cnt[var + 1]++;
             // add to formula
             // clause.push_back(SAGA::lit(ncl + 1, abs(parsed_lit), (parsed_lit > 0) ? 1 : 0));
-
-            // if unit clause
-            if (lits.size() == 1)
-            {
-                // formula.clause_delete[cnt] = true;
-                formula.fixed_vars[abs(parsed_lit)] = (parsed_lit > 0) ? true : false;
-                formula.fix[abs(parsed_lit)] = true;
-            }
             // formula.clause_lit_count[ncl]++;
             // formula.var_lit_count[abs(parsed_lit)]++;
         }
+
+        // if unit clause (only known once the whole clause has been read)
+        if (lits.size() == 1)
+        {
+            // formula.clause_delete[cnt] = true;
+            formula.fix[var(lits[0]) + 1] = true;
+        }
     }
 
     template <class B, class Solver>
@@ -146,7 +128,6 @@ namespace Minisat
         int vars = 0;
         int clauses = 0;
         int cnt = 0;
-        std::vector<unsigned> vars_occ_cnt;
         for (;;)
         {
             skipWhitespace(in);
@@ -163,7 +144,6 @@ namespace Minisat
                     //     S.eliminate(true);
                     formula.setNumClauses(clauses);
                     formula.setNumVariables(vars);
-                    vars_occ_cnt.resize(vars + 1, 0);
                 }
                 else
                 {
@@ -174,15 +154,13 @@ namespace Minisat
                 skipLine(in);
             else
             {
-                readClause(in, S, lits, formula, vars_occ_cnt);
+                readClause(in, S, lits, formula);
                 S.addClause_(lits);
                 // formula.addClause(clause, cnt);
 
                 cnt++;
             }
         }
-        std::vector<unsigned> sorted_variables = get_sorted_variables_by_occurrence(vars_occ_cnt);
-        formula.set_degree_centrality_variables(sorted_variables);
         if (vars != S.nVars())
             fprintf(stderr, "WARNING! DIMACS header mismatch: wrong number of variables.\n");
         if (cnt != clauses)
@@ -0,0 +1,171 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "core/Gaspi.h"
+
+using namespace SAGA::Gaspi;
+
+static void fatal(const char *what)
+{
+    fprintf(stderr, "c ERROR! GASPI shared memory backend: %s failed (%s)\n", what, strerror(errno));
+    exit(1);
+}
+
+static std::size_t align(std::size_t size) { return (size + 63) & ~(std::size_t)63; }
+
+ShmContext::ShmContext(rank_t num_ranks, notification_id_t num_notifications)
+    : rank_(0), size_(num_ranks < 1 ? 1 : num_ranks), num_notifications_(num_notifications), job_(getpid()), control_(nullptr)
+{
+    void *p = mmap(nullptr, sizeof(Control), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        fatal("mmap");
+    control_ = new (p) Control();
+    control_->arrived = 0;
+    control_->generation = 0;
+}
+
+ShmContext::~ShmContext()
+{
+    for (Segment &segment : segments_)
+        if (segment.base)
+            munmap(segment.base, segment.stride * size_);
+    munmap(control_, sizeof(Control));
+}
+
+rank_t ShmContext::start()
+{
+    fflush(stdout);
+    fflush(stderr);
+    for (rank_t r = 1; r < size_; ++r)
+    {
+        pid_t pid = fork();
+        if (pid < 0)
+            fatal("fork");
+        if (pid == 0)
+        {
+            rank_ = r;
+            children_.clear();
+            return rank_;
+        }
+        children_.push_back(pid);
+    }
+    return rank_;
+}
+
+void ShmContext::join()
+{
+    for (int pid : children_)
+        waitpid(pid, nullptr, 0);
+    children_.clear();
+}
+
+// Every rank maps the same object: the first one creates it, the barrier makes sure all have
+// mapped it before rank 0 removes its name.
+void ShmContext::segment_create(segment_id_t seg, std::size_t size)
+{
+    if (seg >= segments_.size())
+        segments_.resize(seg + 1);
+    Segment &segment = segments_[seg];
+    segment.size = size;
+    segment.stride = align(num_notifications_ * sizeof(std::atomic<notification_t>)) + align(size);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/saga-gaspi-%d-%d", job_, (int)seg);
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0)
+        fatal("shm_open");
+    if (ftruncate(fd, segment.stride * size_) != 0)
+        fatal("ftruncate");
+    void *p = mmap(nullptr, segment.stride * size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        fatal("mmap");
+    close(fd);
+    segment.base = (char *)p;
+
+    barrier();
+    if (rank_ == 0)
+        shm_unlink(name);
+}
+
+std::atomic<notification_t> *ShmContext::notifications(segment_id_t seg, rank_t rank)
+{
+    return (std::atomic<notification_t> *)(segments_[seg].base + segments_[seg].stride * rank);
+}
+
+char *ShmContext::data(segment_id_t seg, rank_t rank)
+{
+    return segments_[seg].base + segments_[seg].stride * rank + align(num_notifications_ * sizeof(std::atomic<notification_t>));
+}
+
+void ShmContext::write(segment_id_t local_seg, std::size_t local_offset, rank_t rank,
+                       segment_id_t remote_seg, std::size_t remote_offset, std::size_t size)
+{
+    memcpy(data(remote_seg, rank) + remote_offset, data(local_seg, rank_) + local_offset, size);
+}
+
+void ShmContext::read(segment_id_t local_seg, std::size_t local_offset, rank_t rank,
+                      segment_id_t remote_seg, std::size_t remote_offset, std::size_t size)
+{
+    memcpy(data(local_seg, rank_) + local_offset, data(remote_seg, rank) + remote_offset, size);
+}
+
+// The release store orders the notification after the data written before it
+void ShmContext::notify(segment_id_t remote_seg, rank_t rank, notification_id_t id, notification_t value)
+{
+    notifications(remote_seg, rank)[id].store(value, std::memory_order_release);
+}
+
+bool ShmContext::notify_waitsome(segment_id_t seg, notification_id_t first, notification_id_t num,
+                                 notification_id_t &id, double timeout)
+{
+    std::atomic<notification_t> *notification = notifications(seg, rank_);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout < 0 ? 0 : timeout);
+    for (;;)
+    {
+        for (notification_id_t i = first; i < first + num; ++i)
+        {
+            if (notification[i].load(std::memory_order_acquire) != 0)
+            {
+                id = i;
+                return true;
+            }
+        }
+        if (timeout >= 0 && std::chrono::steady_clock::now() >= deadline)
+            return false;
+        sched_yield();
+    }
+}
+
+notification_t ShmContext::notify_reset(segment_id_t seg, notification_id_t id)
+{
+    return notifications(seg, rank_)[id].exchange(0, std::memory_order_acq_rel);
+}
+
+// Writes are completed by the copy itself, only order them with respect to later operations
+void ShmContext::wait()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+// Sense-reversing barrier: the last rank to arrive opens the next generation
+void ShmContext::barrier()
+{
+    uint32_t generation = control_->generation.load(std::memory_order_acquire);
+    if (control_->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == (uint32_t)size_)
+    {
+        control_->arrived.store(0, std::memory_order_relaxed);
+        control_->generation.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    while (control_->generation.load(std::memory_order_acquire) == generation)
+        sched_yield();
+}
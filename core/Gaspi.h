@@ -0,0 +1,126 @@
+#ifndef _GASPI_H_
+#define _GASPI_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SAGA
+{
+    namespace Gaspi
+    {
+
+        typedef int rank_t;
+        typedef uint8_t segment_id_t;
+        typedef uint32_t notification_id_t;
+        typedef uint32_t notification_t; // 0 means "no notification".
+
+        static const double block = -1.0; // Timeout value of the blocking calls.
+
+        // One-sided communication between the ranks of a job, modeled on the GASPI specification.
+        // Every rank owns a slice of each segment; a rank reads and writes the slices of the other
+        // ranks without their participation, and signals the arrival of data with notifications.
+        // A write followed by a notification of the same target is delivered in that order.
+        class Context
+        {
+        public:
+            virtual ~Context() {}
+
+            virtual rank_t rank() const = 0;
+            virtual rank_t size() const = 0;
+
+            // Collective: create segment 'seg' with 'size' bytes per rank, zero filled
+            virtual void segment_create(segment_id_t seg, std::size_t size) = 0;
+            virtual void *segment_ptr(segment_id_t seg) = 0;
+
+            // Copy 'size' bytes of the local slice of segment 'local_seg' to the slice of 'rank' (write),
+            // or the other way around (read)
+            virtual void write(segment_id_t local_seg, std::size_t local_offset, rank_t rank,
+                               segment_id_t remote_seg, std::size_t remote_offset, std::size_t size) = 0;
+            virtual void read(segment_id_t local_seg, std::size_t local_offset, rank_t rank,
+                              segment_id_t remote_seg, std::size_t remote_offset, std::size_t size) = 0;
+
+            // Set notification 'id' of segment 'remote_seg' on 'rank' to 'value' (which must not be 0)
+            virtual void notify(segment_id_t remote_seg, rank_t rank, notification_id_t id, notification_t value) = 0;
+
+            void write_notify(segment_id_t local_seg, std::size_t local_offset, rank_t rank,
+                              segment_id_t remote_seg, std::size_t remote_offset, std::size_t size,
+                              notification_id_t id, notification_t value)
+            {
+                write(local_seg, local_offset, rank, remote_seg, remote_offset, size);
+                notify(remote_seg, rank, id, value);
+            }
+
+            // Wait until one of the local notifications [first, first + num) of 'seg' is set and store
+            // its id. A timeout of 0 only tests, 'block' waits forever. Returns false on timeout.
+            virtual bool notify_waitsome(segment_id_t seg, notification_id_t first, notification_id_t num,
+                                         notification_id_t &id, double timeout) = 0;
+            // Atomically read and clear a local notification
+            virtual notification_t notify_reset(segment_id_t seg, notification_id_t id) = 0;
+
+            // Wait for the completion of the writes and notifications posted so far
+            virtual void wait() = 0;
+            virtual void barrier() = 0;
+        };
+
+        // Backend for the ranks of one node: rank 0 forks the other ranks and the segments are POSIX
+        // shared memory objects mapped by every rank, so writes and reads are plain copies.
+        class ShmContext : public Context
+        {
+        public:
+            explicit ShmContext(rank_t num_ranks, notification_id_t num_notifications = 1024);
+            ~ShmContext();
+
+            // Fork the ranks 1 .. size() - 1, each returns its own rank
+            rank_t start();
+            // Rank 0: wait for the termination of the other ranks
+            void join();
+
+            rank_t rank() const { return rank_; }
+            rank_t size() const { return size_; }
+
+            void segment_create(segment_id_t seg, std::size_t size);
+            void *segment_ptr(segment_id_t seg) { return data(seg, rank_); }
+
+            void write(segment_id_t local_seg, std::size_t local_offset, rank_t rank,
+                       segment_id_t remote_seg, std::size_t remote_offset, std::size_t size);
+            void read(segment_id_t local_seg, std::size_t local_offset, rank_t rank,
+                      segment_id_t remote_seg, std::size_t remote_offset, std::size_t size);
+            void notify(segment_id_t remote_seg, rank_t rank, notification_id_t id, notification_t value);
+            bool notify_waitsome(segment_id_t seg, notification_id_t first, notification_id_t num,
+                                 notification_id_t &id, double timeout);
+            notification_t notify_reset(segment_id_t seg, notification_id_t id);
+            void wait();
+            void barrier();
+
+        private:
+            struct Control
+            {
+                std::atomic<uint32_t> arrived;
+                std::atomic<uint32_t> generation;
+            };
+
+            struct Segment
+            {
+                char *base = nullptr;   // Mapping of the slices of all ranks.
+                std::size_t size = 0;   // Bytes of user data per rank.
+                std::size_t stride = 0; // Bytes between two slices (notifications, data, padding).
+            };
+
+            std::atomic<notification_t> *notifications(segment_id_t seg, rank_t rank);
+            char *data(segment_id_t seg, rank_t rank);
+
+            rank_t rank_;
+            rank_t size_;
+            notification_id_t num_notifications_;
+            int job_;           // Process id of rank 0, names the shared memory objects.
+            Control *control_;  // Barrier state, shared by the ranks since before the fork.
+            std::vector<Segment> segments_;
+            std::vector<int> children_; // Process ids of the other ranks (rank 0 only).
+        };
+
+    }
+}
+
+#endif // _GASPI_H_
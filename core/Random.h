@@ -0,0 +1,87 @@
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <cstdint>
+#include <limits>
+
+namespace SAGA
+{
+
+    // xoshiro256** generator (Blackman and Vigna): 32 bytes of state, a few cycles per number and
+    // a period of 2^256 - 1. Satisfies UniformRandomBitGenerator, so it works with the <random>
+    // distributions. jump() advances the state by 2^128 numbers, which splits one seed into
+    // independent streams (one per island, rank, ...).
+    class Xoshiro256
+    {
+    public:
+        typedef uint64_t result_type;
+
+        explicit Xoshiro256(uint64_t seed_ = 0) { seed(seed_); }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        // Expand the seed with splitmix64, which never yields the all-zero state
+        void seed(uint64_t value)
+        {
+            for (uint64_t &word : s)
+            {
+                uint64_t z = (value += 0x9e3779b97f4a7c15ULL);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                word = z ^ (z >> 31);
+            }
+        }
+
+        result_type operator()()
+        {
+            uint64_t result = rotl(s[1] * 5, 7) * 9;
+            uint64_t t = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= t;
+            s[3] = rotl(s[3], 45);
+            return result;
+        }
+
+        // Equivalent to 2^128 calls to operator()
+        void jump()
+        {
+            static const uint64_t polynomial[4] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+            advance(polynomial);
+        }
+        // Equivalent to 2^192 calls to operator(), separates groups of jump() streams
+        void long_jump()
+        {
+            static const uint64_t polynomial[4] = {0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+            advance(polynomial);
+        }
+
+    private:
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        void advance(const uint64_t (&polynomial)[4])
+        {
+            uint64_t t[4] = {0, 0, 0, 0};
+            for (uint64_t word : polynomial)
+            {
+                for (int b = 0; b < 64; ++b)
+                {
+                    if (word & (uint64_t)1 << b)
+                        for (int i = 0; i < 4; ++i)
+                            t[i] ^= s[i];
+                    (*this)();
+                }
+            }
+            for (int i = 0; i < 4; ++i)
+                s[i] = t[i];
+        }
+
+        uint64_t s[4];
+    };
+
+}
+
+#endif // _RANDOM_H_
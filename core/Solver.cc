@@ -78,6 +78,7 @@ Solver::Solver() :
   , rnd_pol          (false)
   , rnd_init_act     (opt_rnd_init_act)
   , garbage_frac     (opt_garbage_frac)
+  , phase_hook       (NULL)
   , restart_first    (opt_restart_first)
   , restart_inc      (opt_restart_inc)
 
@@ -100,6 +101,7 @@ Solver::Solver() :
   , var_inc            (1)
   , watches_bin        (WatcherDeleted(ca))
   , watches            (WatcherDeleted(ca))
+  , best_trail         (0)
   , qhead              (0)
   , simpDB_assigns     (-1)
   , simpDB_props       (0)
@@ -155,6 +157,7 @@ Var Solver::newVar(bool sign, bool dvar)
     seen     .push(0);
     seen2    .push(0);
     polarity .push(sign);
+    best_polarity.push(sign);
     decision .push();
     trail    .capacity(v+1);
     setDecisionVar(v, dvar);
@@ -289,6 +292,10 @@ bool Solver::satisfied(const Clause& c) const {
 //
 void Solver::cancelUntil(int level) {
     if (decisionLevel() > level){
+        if (phase_hook != NULL && trail.size() > best_trail && phase_hook->usesBestPhases()){
+            best_trail = trail.size();
+            for (int c = trail_lim[0]; c < trail.size(); c++)
+                best_polarity[var(trail[c])] = sign(trail[c]); }
         for (int c = trail.size()-1; c >= trail_lim[level]; c--){
             Var      x  = var(trail[c]);
 
@@ -1054,6 +1061,10 @@ lbool Solver::search(int& nof_conflicts)
                 // Reached bound on number of conflicts:
                 progress_estimate = progressEstimate();
                 cancelUntil(0);
+                if (phase_hook != NULL){
+                    phase_hook->fetch(polarity);
+                    if (phase_hook->rephase(polarity, best_polarity, starts, conflicts))
+                        best_trail = 0; }
                 return l_Undef; }
 
             // Simplify the set of problem clauses:
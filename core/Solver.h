@@ -48,6 +48,22 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 namespace Minisat
 {
 
+    //=================================================================================================
+    // PhaseHook -- source of preferred polarities computed outside of the search:
+
+    class PhaseHook
+    {
+    public:
+        virtual ~PhaseHook() {}
+        // Both are called at every restart and return true after writing new preferred polarities into
+        // 'polarity'. fetch() adopts phases found meanwhile, rephase() may compute them from the saved
+        // phases and the phases 'best' of the longest trail since the last rephasing.
+        virtual bool fetch(vec<char> &polarity) { return false; }
+        virtual bool rephase(vec<char> &polarity, const vec<char> &best, uint64_t restarts, uint64_t conflicts) { return false; }
+        // True if rephase() reads 'best', which the solver only keeps up to date in that case
+        virtual bool usesBestPhases() const { return false; }
+    };
+
     //=================================================================================================
     // Solver -- the main class:
 
@@ -147,6 +163,7 @@ namespace Minisat
 
         // Read state:
         //
+        bool isDecision(Var x) const { return decision[x]; } // False for variables removed by elimination.
         lbool value(Var x) const;      // The current value of a variable.
         lbool value(Lit p) const;      // The current value of a literal.
         lbool modelValue(Var x) const; // The value of a variable in the last model. The last call to solve must have been satisfiable.
@@ -195,6 +212,7 @@ namespace Minisat
         bool rnd_pol;        // Use random polarities for branching heuristics.
         bool rnd_init_act;   // Initialize variable activities with a small random value.
         double garbage_frac; // The fraction of wasted memory allowed before a garbage collection is triggered.
+        PhaseHook *phase_hook; // Polled for new polarities at every restart (NULL = none).
 
         int restart_first;        // The initial restart limit.                                                                (default 100)
         double restart_inc;       // The factor with which the restart limit is multiplied in each restart.                    (default 1.5)
@@ -215,6 +233,9 @@ namespace Minisat
 
         // returns the vector containing the clauses of the original formula
         vec<CRef> &getOriginalclauses() { return clauses; }
+        // returns the learnt clauses kept for good (core) or for a while (tier2)
+        vec<CRef> &getCoreLearnts() { return learnts_core; }
+        vec<CRef> &getTier2Learnts() { return learnts_tier2; }
         //
         ClauseAllocator &getCa() { return ca; }
 
@@ -271,6 +292,8 @@ namespace Minisat
             watches;                     // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
         vec<lbool> assigns;              // The current assignments.
         vec<char> polarity;              // The preferred polarity of each variable.
+        vec<char> best_polarity;         // Polarities of the longest trail since the last rephasing (kept only for a phase hook using them).
+        int best_trail;                  // Size of that trail.
         vec<char> decision;              // Declares if a variable is eligible for selection in the decision heuristic.
         vec<Lit> trail;                  // Assignment stack; stores all assigments made in the order they were made.
         vec<int> trail_lim;              // Separator indices for different decision levels in 'trail'.
@@ -0,0 +1,36 @@
+#include <cinttypes>
+#include "core/Telemetry.h"
+
+using namespace SAGA;
+
+Telemetry::Telemetry(const char *path, int format) : file_(fopen(path, "w")), format_(format)
+{
+    if (file_ && format_ == FORMAT_CSV)
+        fprintf(file_, "run,island,generation,time,best,median,worst,diversity,full,delta,inherited,cached,"
+                       "selection,crossover,mutation,evaluation,improvement\n");
+}
+
+Telemetry::~Telemetry()
+{
+    if (file_)
+        fclose(file_);
+}
+
+void Telemetry::write(const GenerationStats &s)
+{
+    if (!file_)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (format_ == FORMAT_CSV)
+        fprintf(file_, "%" PRIu64 ",%d,%d,%.6f,%d,%d,%d,%.3f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.6f,%.6f,%.6f,%.6f,%.6f\n",
+                s.run, s.island, s.generation, s.time, s.best, s.median, s.worst, s.diversity,
+                s.full, s.delta, s.inherited, s.cached,
+                s.selection, s.crossover, s.mutation, s.evaluation, s.improvement);
+    else
+        fprintf(file_, "{\"run\":%" PRIu64 ",\"island\":%d,\"generation\":%d,\"time\":%.6f,\"best\":%d,\"median\":%d,\"worst\":%d,"
+                       "\"diversity\":%.3f,\"full\":%" PRIu64 ",\"delta\":%" PRIu64 ",\"inherited\":%" PRIu64 ",\"cached\":%" PRIu64 ","
+                       "\"selection\":%.6f,\"crossover\":%.6f,\"mutation\":%.6f,\"evaluation\":%.6f,\"improvement\":%.6f}\n",
+                s.run, s.island, s.generation, s.time, s.best, s.median, s.worst, s.diversity,
+                s.full, s.delta, s.inherited, s.cached,
+                s.selection, s.crossover, s.mutation, s.evaluation, s.improvement);
+}
@@ -0,0 +1,66 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+namespace SAGA
+{
+
+    // Statistics of one generation of one island
+    struct GenerationStats
+    {
+        uint64_t run;   // solve() or refine() call of the GA, from 1.
+        int island;
+        int generation; // Generations of the island so far, this one included.
+        double time;    // Wall-clock seconds since the start of the run.
+
+        int best;
+        int median;
+        int worst;
+        double diversity; // Mean Hamming distance between two individuals of the population.
+
+        // Offspring evaluations (cf. EvaluationCounts), 'cached' of the full ones were cache hits
+        uint64_t full;
+        uint64_t delta;
+        uint64_t inherited;
+        uint64_t cached;
+
+        // Wall-clock seconds of each step of the generation
+        double selection;   // Parents and survivors.
+        double crossover;
+        double mutation;
+        double evaluation;
+        double improvement; // Repair and local search.
+    };
+
+    // Sink of the per-generation statistics, written as CSV (after a header line) or as JSON lines
+    // through the stdio buffer. Records of concurrent islands are serialized.
+    class Telemetry
+    {
+    public:
+        enum Format
+        {
+            FORMAT_CSV,
+            FORMAT_JSONL
+        };
+
+        Telemetry(const char *path, int format);
+        ~Telemetry();
+
+        Telemetry(const Telemetry &) = delete;
+        Telemetry &operator=(const Telemetry &) = delete;
+
+        bool ok() const { return file_ != nullptr; } // False if the file could not be opened.
+        void write(const GenerationStats &stats);
+
+    private:
+        FILE *file_;
+        int format_;
+        std::mutex mutex_;
+    };
+
+}
+
+#endif // _TELEMETRY_H_
@@ -0,0 +1,123 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SAGA
+{
+
+    // Fixed set of worker threads used to spread independent SAGA tasks (e.g. the fitness
+    // evaluation of the individuals of a population) over several cores. The calling thread
+    // takes part in the work, so a pool of size n starts n - 1 workers.
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(unsigned num_threads)
+            : num_threads_(num_threads < 1 ? 1 : num_threads), job_size_(0), next_(0), pending_(0), generation_(0), stop_(false)
+        {
+            for (unsigned t = 1; t < num_threads_; ++t)
+                workers_.emplace_back(&ThreadPool::worker, this);
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto &worker : workers_)
+                worker.join();
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        unsigned size() const { return num_threads_; }
+
+        // Call body(i) for every i in [0, n) and return once all calls have completed.
+        // Indices are handed out dynamically, so the order of the calls is unspecified.
+        void parallel_for(std::size_t n, const std::function<void(std::size_t)> &body)
+        {
+            if (n == 0)
+                return;
+            if (workers_.empty() || n == 1)
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                    body(i);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job_ = &body;
+                job_size_ = n;
+                next_.store(0);
+                pending_ = workers_.size();
+                generation_++;
+            }
+            wake_.notify_all();
+
+            run(body, n);
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this]
+                       { return pending_ == 0; });
+            job_ = nullptr;
+        }
+
+    private:
+        void run(const std::function<void(std::size_t)> &body, std::size_t n)
+        {
+            for (std::size_t i = next_.fetch_add(1); i < n; i = next_.fetch_add(1))
+                body(i);
+        }
+
+        void worker()
+        {
+            std::size_t seen = 0;
+            for (;;)
+            {
+                const std::function<void(std::size_t)> *job;
+                std::size_t n;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wake_.wait(lock, [this, seen]
+                               { return stop_ || generation_ != seen; });
+                    if (stop_)
+                        return;
+                    seen = generation_;
+                    job = job_;
+                    n = job_size_;
+                }
+
+                run(*job, n);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0)
+                    done_.notify_one();
+            }
+        }
+
+        unsigned num_threads_;
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        const std::function<void(std::size_t)> *job_ = nullptr;
+        std::size_t job_size_;
+        std::atomic<std::size_t> next_;
+        std::size_t pending_;
+        std::size_t generation_;
+        bool stop_;
+    };
+
+}
+
+#endif // _THREAD_POOL_H_
@@ -1,1094 +1,1682 @@
 #include <random>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 #include "saga.h"
 
 using namespace SAGA;
+using Minisat::lbool;
 
-// Initialize the population with random solutions
-void GeneticAlgorithm::initialize_population(std::mt19937 rng)
+// Number the variables left free by simplification
+void GeneMap::build(Minisat::Solver &solver, const Formula &formula)
 {
+    vars.assign(1, var_Undef);
+    genes.assign(solver.nVars(), 0);
+    for (Minisat::Var v = 0; v < solver.nVars(); ++v)
+    {
+        bool fixed = (std::size_t)v + 1 < formula.fix.size() && formula.fix[v + 1];
+        if (fixed || !solver.isDecision(v) || solver.value(v) != l_Undef)
+            continue;
+        genes[v] = vars.size();
+        vars.push_back(v);
+    }
+}
 
-    // Create a uniform distribution for integers in [0, 1]
-    std::uniform_int_distribution<int> dist(0, 1);
+void PhaseExchange::publish(const Solution &solution, int fitness)
+{
+    if (fitness >= best.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fitness >= best)
+        return;
+    for (std::size_t g = 1; g < phases.size(); ++g)
+        phases[g] = solution[g];
+    best = fitness;
+    fresh = true;
+}
 
-    int nclauses = formula_.getNumClauses();
-    int nvars = formula_.getNumVariables();
-    for (std::size_t i = 0; i < population_size_; i++)
+// The solver skips a restart rather than waiting while the GA publishes
+bool PhaseExchange::fetch(Minisat::vec<char> &polarity)
+{
+    if (!fresh)
+        return false;
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return false;
+    for (std::size_t g = 1; g < phases.size(); ++g)
+        polarity[genes.var(g)] = phases[g];
+    fresh = false;
+    updates++;
+    return true;
+}
+
+// Copy the original clauses into a flat literal array, simplified by the variables without a gene
+void ClauseView::build(Minisat::Solver &solver, const GeneMap &genes)
+{
+    literals.clear();
+    offsets.assign(1, 0);
+    weights.clear();
+    num_empty = 0;
+    total_weight = 0;
+    add(solver, genes, solver.getOriginalclauses(), true);
+    num_original = numClauses();
+}
+
+void ClauseView::add_learnts(Minisat::Solver &solver, const GeneMap &genes, Minisat::vec<Minisat::CRef> &learnts, unsigned mark, int weight)
+{
+    learnt_weight = weight;
+    add(solver, genes, learnts, false, mark);
+}
+
+void ClauseView::clear_learnts()
+{
+    for (std::size_t c = num_original; c < numClauses(); ++c)
+        total_weight -= weights[c];
+    offsets.resize(num_original + 1);
+    literals.resize(offsets.back());
+    weights.resize(num_original);
+}
+
+// A learnt clause falsified at level 0 would have made the solver unsatisfiable, only original
+// clauses can be empty
+void ClauseView::add(Minisat::Solver &solver, const GeneMap &genes, Minisat::vec<Minisat::CRef> &clauses, bool original, unsigned mark)
+{
+    Minisat::ClauseAllocator &ca = solver.getCa();
+    offsets.reserve(offsets.size() + clauses.size());
+
+    for (int c = 0; c < clauses.size(); ++c)
     {
-        // Create a new solution with random values in its vector
-        Solution sol(nvars + 1, nclauses);
-        assert(sol.getSolution().size() == nvars + 1);
-        assert(formula_.fix.size() == nvars + 1);
-        assert(formula_.fixed_vars.size() == nvars + 1);
-        for (std::size_t j = 1; j <= nvars; ++j)
+        Minisat::Clause &clause = ca[clauses[c]];
+        if (!original && clause.mark() != mark)
+            continue;
+        std::size_t start = literals.size();
+        bool sat = false;
+
+        for (int j = 0; j < clause.size() && !sat; ++j)
         {
-            if (formula_.fix[j])
-                sol[j] = formula_.fixed_vars[j] ? 1 : 0;
-            else
-                sol[j] = dist(rng); // generate a random bit using the distribution and the generator
+            uint32_t g = genes.gene(Minisat::var(clause[j]));
+            if (g == 0)
+            {
+                // Variables without a gene keep their level 0 value
+                sat = solver.value(clause[j]) == l_True;
+                continue;
+            }
+            literals.push_back(g << 1 | Minisat::sign(clause[j]));
+        }
+
+        if (sat || (!original && literals.size() == start))
+            literals.resize(start);
+        else if (literals.size() == start)
+            num_empty++;
+        else
+        {
+            offsets.push_back(literals.size());
+            weights.push_back(original ? 1 : learnt_weight);
+            total_weight += weights.back();
         }
-        population_.push_back(sol); // Add the solution to the population
     }
 }
 
-int GeneticAlgorithm::fitness(Solution &solution)
+// Build the literal-to-clause occurrence index of the view
+void IncrementalEvaluator::build(const ClauseView &view_, std::size_t num_genes)
 {
+    view = &view_;
+    occ_offsets.assign(2 * num_genes + 1, 0);
+    for (std::size_t c = 0; c < view->numClauses(); ++c)
+        for (const uint32_t *lit = view->begin(c); lit != view->end(c); ++lit)
+            occ_offsets[*lit + 1]++;
+    for (std::size_t l = 1; l < occ_offsets.size(); ++l)
+        occ_offsets[l] += occ_offsets[l - 1];
+
+    occurrences.resize(view->numLiterals());
+    std::vector<uint32_t> fill(occ_offsets.begin(), occ_offsets.end() - 1);
+    for (std::size_t c = 0; c < view->numClauses(); ++c)
+        for (const uint32_t *lit = view->begin(c); lit != view->end(c); ++lit)
+            occurrences[fill[*lit]++] = c;
+}
 
-    if (memo.contains(solution.getSolution()))
+void IncrementalEvaluator::init(Solution &solution) const
+{
+    std::vector<uint32_t> &counts = solution.getTrueCounts();
+    counts.assign(view->numClauses(), 0);
+    const uint64_t *genes = solution.data();
+    int unsat = view->numEmpty();
+    for (std::size_t c = 0; c < view->numClauses(); ++c)
     {
-        // std::cout << "memo hit" << std::endl;
-        int fit = memo.get(solution.getSolution()).get_value_or(formula_.getNumClauses());
-        return fit;
+        for (const uint32_t *lit = view->begin(c); lit != view->end(c); ++lit)
+            counts[c] += ClauseView::satisfied(*lit, genes);
+        if (counts[c] == 0)
+            unsat += view->weight(c);
     }
-    else
+    solution.setFitness(unsat);
+}
+
+// Bring the counters up to date with the genes set in 'bits' of word 'w', which already changed, and
+// return the fitness 'unsat' updated accordingly
+int IncrementalEvaluator::update(Solution &solution, std::size_t w, uint64_t bits, int unsat) const
+{
+    uint32_t *counts = solution.getTrueCounts().data();
+    while (bits)
     {
-        bool sat = false;
-        int fitness = 0;
-        Minisat::ClauseAllocator &ca = solver_.getCa();
-        Minisat::vec<Minisat::CRef> &clauses = solver_.getOriginalclauses();
-        assert(clauses.size() != 0);
-        assert(ca.size() != 0);
-        std::vector<int> unsat_vars;
-
-        for (int c = 0; c < clauses.size(); ++c)
-        {
-            // std::cout << "Start looking for unsat clauses" << std::endl;
-            sat = 0;
+        uint32_t gene = (w << 6) | __builtin_ctzll(bits);
+        bits &= bits - 1;
+
+        // The literal whose sign equals the new gene value became true, its negation became false
+        uint32_t made = gene << 1 | solution.get(gene);
+        uint32_t broken = made ^ 1;
+        for (uint32_t i = occ_offsets[made]; i < occ_offsets[made + 1]; ++i)
+            if (counts[occurrences[i]]++ == 0)
+                unsat -= view->weight(occurrences[i]);
+        for (uint32_t i = occ_offsets[broken]; i < occ_offsets[broken + 1]; ++i)
+            if (--counts[occurrences[i]] == 0)
+                unsat += view->weight(occurrences[i]);
+    }
+    return unsat;
+}
 
-            Minisat::Clause &clause = ca[clauses[c]];
+// Net change of every word of the solution, in a scratch buffer of the calling thread
+const std::vector<uint64_t> &IncrementalEvaluator::net_changes(const Solution &solution) const
+{
+    static thread_local std::vector<uint64_t> net;
+    net.assign(solution.numWords(), 0);
+    for (const Solution::Change &change : solution.getChanges())
+        net[change.first] ^= change.second;
+    return net;
+}
 
-            for (int j = 0; j < clause.size(); ++j)
-            {
-                int cur_var = Minisat::var(clause[j]) + 1;
+void IncrementalEvaluator::apply_changes(Solution &solution) const
+{
+    const std::vector<uint64_t> &net = net_changes(solution);
+    int unsat = solution.getFitness();
+    for (std::size_t w = 0; w < net.size(); ++w)
+        if (net[w])
+            unsat = update(solution, w, net[w], unsat);
+    solution.setFitness(unsat);
+}
 
-                if (Minisat::sign(clause[j]) == solution[cur_var])
-                {
-                    sat += 1;
-                    break;
-                }
-                // else
-                // {
-                //     if (!formula_.fix[cur_var])
-                //     {
-                //         // std::cout << "cur_var " << cur_var << std::endl;
-                //         if (std::find(formula_.get_degree_centrality_variables().begin(), formula_.get_degree_centrality_variables().end(), cur_var) != formula_.get_degree_centrality_variables().end())
-                //             unsat_vars.push_back(cur_var);
-                //     }
-                // }
-            }
+int IncrementalEvaluator::delta(const Solution &solution) const
+{
+    static thread_local std::vector<uint64_t> before; // Chromosome before the changes.
+    static thread_local std::vector<uint32_t> stamps; // Clauses visited by this call are marked with stamp.
+    static thread_local uint32_t stamp = 0;
+
+    const std::vector<uint64_t> &net = net_changes(solution);
+    before.assign(solution.getWords().begin(), solution.getWords().end());
+    for (std::size_t w = 0; w < net.size(); ++w)
+        before[w] ^= net[w];
+    if (stamps.size() < view->numClauses() || ++stamp == 0)
+    {
+        stamps.assign(std::max(stamps.size(), view->numClauses()), 0);
+        stamp = 1;
+    }
 
-            if (sat == 0)
+    int unsat = solution.getFitness();
+    for (std::size_t w = 0; w < net.size(); ++w)
+    {
+        for (uint64_t bits = net[w]; bits; bits &= bits - 1)
+        {
+            uint32_t gene = (w << 6) | __builtin_ctzll(bits);
+            for (uint32_t i = occ_offsets[gene << 1]; i < occ_offsets[(gene << 1) + 2]; ++i)
             {
-                // add all unsat variables to the solution
-                // for (auto lit : unsat_vars)
-                //     solution.add_unsatisfying_variable(lit);
-                fitness++;
+                uint32_t c = occurrences[i];
+                if (stamps[c] == stamp)
+                    continue;
+                stamps[c] = stamp;
+                bool was = view->clauseSatisfied(c, before.data());
+                bool is = view->clauseSatisfied(c, solution.data());
+                if (was != is)
+                    unsat += is ? -view->weight(c) : view->weight(c);
             }
-            // else
-            // {
-            //     unsat_vars.clear();
-            // }
         }
-
-        memo.insert(solution.getSolution(), fitness);
-        return fitness;
     }
+    return unsat;
 }
 
-// Evaluate the fitness of each solution in the population
-void GeneticAlgorithm::evaluate_fitness()
+std::size_t IncrementalEvaluator::changed_occurrences(const Solution &solution) const
 {
-    for (std::size_t i = 0; i < population_size_; ++i)
+    std::size_t visits = 0;
+    for (const Solution::Change &change : solution.getChanges())
     {
-        assert(population_[i].size() == formula_.getNumVariables() + 1);
-        assert(i < population_.getPopulation().size());
-        // Evaluate the fitness of each solution using the fitness function
-        // std::cout << "fitness = " << population_.population[i].fitness << std::endl;
-        population_[i].setFitness(fitness(population_[i]));
+        for (uint64_t bits = change.second; bits; bits &= bits - 1)
+        {
+            uint32_t gene = (change.first << 6) | __builtin_ctzll(bits);
+            visits += occ_offsets[(gene << 1) + 2] - occ_offsets[gene << 1];
+        }
     }
-    // Sort the population by fitness in descending order (best solutions first)
-    // std::sort(population_.getPopulation().begin(), population_.getPopulation().end(), [](const Solution &a, const Solution &b)
-    //           { return a.getFitness() < b.getFitness(); });
-    population_.sort();
-    // std::cout << "best fitness = " << population_.population[0].fitness << std::endl;
+    return visits;
 }
-// Evaluate the fitness of the offspring
-void GeneticAlgorithm::evaluate_fitness(std::vector<Solution> &offspring)
+
+// ProbSAT polynomial break scheme, with the usual constants for 3-SAT
+static const double ls_cb = 2.3;
+static const double ls_eps = 1.0;
+static const std::size_t ls_max_break = 64;
+
+void LocalSearch::build(const ClauseView &view_, const IncrementalEvaluator &evaluator_)
 {
-    for (auto &sol : offspring)
-    {
-        sol.setFitness(fitness(sol));
-    }
+    view = &view_;
+    evaluator = &evaluator_;
+    break_weights.resize(ls_max_break + 1);
+    for (std::size_t b = 0; b <= ls_max_break; ++b)
+        break_weights[b] = std::pow(ls_eps + b, -ls_cb);
 }
 
-// Select parents using tournament selection
-std::vector<Solution> GeneticAlgorithm::select_parents_tournament(std::mt19937 rng)
+void LocalSearch::improve(Solution &solution, int steps, Xoshiro256 &rng) const
 {
-    // Create a vector to store the selected parents
-    std::vector<Solution> parents;
-    parents.reserve(population_size_ / 2);
-    // Create a uniform distribution for integers in [0, population_size_ - 1]
-    std::uniform_int_distribution<int> dist(0, population_size_ - 1);
+    // Scratch buffers of the calling thread, kept between calls
+    static thread_local std::vector<uint32_t> scratch_counts;
+    static thread_local std::vector<uint32_t> unsat; // Unsatisfied clauses of the view.
+    static thread_local std::vector<uint32_t> where; // Position of each unsatisfied clause in unsat.
+    static thread_local std::vector<uint32_t> flips; // Genes flipped so far, to go back to the best assignment.
+    static thread_local std::vector<double> cumulative;
+
+    const std::size_t nclauses = view->numClauses();
+    bool own = solution.hasTrueCounts();
+    std::vector<uint32_t> &counts = own ? solution.getTrueCounts() : scratch_counts;
+    if (!own)
+    {
+        counts.assign(nclauses, 0);
+        const uint64_t *genes = solution.data();
+        for (std::size_t c = 0; c < nclauses; ++c)
+            for (const uint32_t *lit = view->begin(c); lit != view->end(c); ++lit)
+                counts[c] += ClauseView::satisfied(*lit, genes);
+    }
 
-    for (std::size_t i = 0; i < (population_size_ / 2); ++i)
+    unsat.clear();
+    where.resize(nclauses);
+    int cost = view->numEmpty(); // Fitness of the current assignment.
+    for (std::size_t c = 0; c < nclauses; ++c)
     {
-        // Select two random solutions from the population as candidates for reproduction
-        int index1 = dist(rng);
-        int index2 = dist(rng);
-        Solution &candidate1 = population_[index1];
-        Solution &candidate2 = population_[index2];
-
-        // Compare their fitness and select the fitter one as a parent
-        if (candidate1.getFitness() < candidate2.getFitness())
+        if (counts[c] == 0)
         {
-            parents.push_back(std::move(candidate1));
+            where[c] = unsat.size();
+            unsat.push_back(c);
+            cost += view->weight(c);
         }
-        else
+    }
+
+    auto flip = [&](uint32_t gene)
+    {
+        solution.flip(gene);
+        uint32_t made = gene << 1 | solution.get(gene);
+        for (const uint32_t *c = evaluator->occ_begin(made); c != evaluator->occ_end(made); ++c)
         {
-            parents.push_back(std::move(candidate2));
+            if (counts[*c]++ == 0)
+            {
+                cost -= view->weight(*c);
+                uint32_t last = unsat.back();
+                unsat[where[*c]] = last;
+                where[last] = where[*c];
+                unsat.pop_back();
+            }
+        }
+        for (const uint32_t *c = evaluator->occ_begin(made ^ 1); c != evaluator->occ_end(made ^ 1); ++c)
+        {
+            if (--counts[*c] == 0)
+            {
+                cost += view->weight(*c);
+                where[*c] = unsat.size();
+                unsat.push_back(*c);
+            }
+        }
+    };
+
+    flips.clear();
+    int best = cost;
+    std::size_t best_flips = 0;
+    for (int step = 0; step < steps && !unsat.empty(); ++step)
+    {
+        // Pick a variable of a random unsatisfied clause with probability decreasing in its break value
+        uint32_t c = unsat[std::uniform_int_distribution<std::size_t>(0, unsat.size() - 1)(rng)];
+        cumulative.clear();
+        double total = 0;
+        for (const uint32_t *lit = view->begin(c); lit != view->end(c); ++lit)
+        {
+            std::size_t breaks = 0;
+            uint32_t satisfied = *lit ^ 1;
+            for (const uint32_t *d = evaluator->occ_begin(satisfied); d != evaluator->occ_end(satisfied); ++d)
+                if (counts[*d] == 1)
+                    breaks += view->weight(*d);
+            total += break_weights[std::min(breaks, ls_max_break)];
+            cumulative.push_back(total);
+        }
+        double x = std::uniform_real_distribution<double>(0, total)(rng);
+        std::size_t k = std::upper_bound(cumulative.begin(), cumulative.end(), x) - cumulative.begin();
+        uint32_t gene = ClauseView::gene(view->begin(c)[std::min(k, cumulative.size() - 1)]);
+
+        flip(gene);
+        flips.push_back(gene);
+        if (cost < best)
+        {
+            best = cost;
+            best_flips = flips.size();
         }
     }
 
-    return parents;
+    // Undo the flips made after the best assignment of the walk
+    while (flips.size() > best_flips)
+    {
+        flip(flips.back());
+        flips.pop_back();
+    }
+    solution.setFitness(cost);
 }
 
-std::vector<Solution> GeneticAlgorithm::select_parents_random(std::mt19937 rng)
+void UnitRepair::build(const ClauseView &view_, const IncrementalEvaluator &evaluator_, const std::vector<unsigned> &order_,
+                       std::size_t num_genes)
 {
-    std::vector<Solution> parents;
-    parents.reserve(population_size_ / 2);
-    // Create a uniform distribution for integers in [0, population_size_ - 1]
-    std::uniform_int_distribution<int> dist(0, population_size_ - 1);
-    for (int i = 0; i < (population_size_ / 2); ++i)
+    view = &view_;
+    evaluator = &evaluator_;
+    std::vector<bool> listed(num_genes, false);
+    order.clear();
+    for (unsigned g : order_)
     {
-        int index = dist(rng);
-        parents.push_back(std::move(population_[index]));
+        if (g == 0 || g >= num_genes || listed[g])
+            continue;
+        listed[g] = true;
+        order.push_back(g);
     }
-    return parents;
-}
-
-// void GeneticAlgorithm::mutate(Solution &solution, std::mt19937 rng)
-// {
-//     // Create a uniform distribution for floats in [0.0, 1.0]
-//     std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-
-//     if (solution.no_unsatisfying_variables())
-//     {
-//         std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-//         for (auto &var : centrality_vars)
-//         {
-
-//             if (dist(rng) < mutation_rate_ && !formula_.fix[var])
-//             {
-//                 solution[var] = 1 - solution[var];
-//             }
-//         }
-//     }
-//     else
-//     {
-
-//         std::vector<int> unsat_vars = solution.get_unsatisfying_variables();
-//         for (auto &var : unsat_vars)
-//         {
-//             if (dist(rng) < mutation_rate_ && !formula_.fix[var])
-//             {
-//                 solution[var] = 1 - solution[var];
-//             }
-//         }
-//     }
-// }
-
-// void GeneticAlgorithm::mutate(Solution &solution, std::mt19937 rng)
-// {
-//     // Create a uniform distribution for floats in [0.0, 1.0]
-//     std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-//     std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-//     for (auto &var : centrality_vars)
-//     {
-
-//         if (dist(rng) < mutation_rate_ && !formula_.fix[var])
-//         {
-//             solution[var] = 1 - solution[var];
-//         }
-//     }
-// }
-
-// Create offspring through crossover and mutation
-std::vector<Solution> GeneticAlgorithm::create_offspring(const std::vector<Solution> &parents, std::mt19937 rng)
-{
-    // Create a vector to store the offspring solutions
-    std::vector<Solution> offspring;
-    offspring.reserve(parents.size());
+    for (std::size_t g = 1; g < num_genes; ++g)
+        if (!listed[g])
+            order.push_back(g);
+}
 
-    // Create a uniform distribution for floats in [0.0, 1.0]
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    // Create a uniform distribution for integers in [1, solution_size_ - 2]
-    std::uniform_int_distribution<int> dist2(1, solution_size_ - 2);
-    // Create a uniform distribution for integers in [0, parents.size() - 1]
-    std::uniform_int_distribution<int> dist3(0, parents.size() - 1);
+void UnitRepair::repair(Solution &solution) const
+{
+    propagate(solution, order);
+}
 
-    for (std::size_t i = 0; i < parents.size() - 1; i += 2)
-    {
-        // Select two parents from the vector using their index
-        Solution parent1 = parents[i];
-        Solution parent2 = parents[i + 1];
-        // Solution parent1 = parents[dist3(rng)];
-        // Solution parent2 = parents[dist3(rng)];
+void UnitRepair::dive(Solution &solution, Xoshiro256 &rng) const
+{
+    static thread_local std::vector<uint32_t> shuffled;
+    shuffled.assign(order.begin(), order.end());
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    propagate(solution, shuffled);
+}
 
-        Solution child1(parent1);
-        Solution child2(parent2);
+// Decide the genes of 'decisions' in turn, each followed by unit propagation
+void UnitRepair::propagate(Solution &solution, const std::vector<uint32_t> &decisions) const
+{
+    // Scratch buffers of the calling thread: a gene is assigned iff its stamp is the current one
+    static thread_local std::vector<uint32_t> assigned;
+    static thread_local uint32_t stamp = 0;
+    static thread_local std::vector<uint32_t> falsified; // Literals made false, to propagate.
 
-        // Perform crossover with a given probability
-        if (dist(rng) < crossover_rate_)
-        {
-            // Select a random point to split the solution vector
-            int point = dist2(rng);
-            // std::cout << "point: " << point << std::endl;
+    if (assigned.size() < solution.size() || ++stamp == 0)
+    {
+        assigned.assign(std::max(assigned.size(), solution.size()), 0);
+        stamp = 1;
+    }
+    auto assign = [&](uint32_t gene, unsigned value)
+    {
+        assigned[gene] = stamp;
+        solution.set(gene, value);
+        falsified.push_back(gene << 1 | (value ^ 1));
+    };
 
-            for (int j = 1; j <= point; ++j)
+    for (uint32_t decision : decisions)
+    {
+        if (assigned[decision] == stamp)
+            continue;
+        falsified.clear();
+        assign(decision, solution.get(decision));
+        for (std::size_t head = 0; head < falsified.size(); ++head)
+        {
+            uint32_t lit = falsified[head];
+            for (const uint32_t *c = evaluator->occ_begin(lit); c != evaluator->occ_end(lit); ++c)
             {
-                if (!formula_.fix[j])
+                // Look for a clause without true literal and with a single unassigned one
+                uint32_t unit = 0;
+                int unassigned = 0;
+                bool sat = false;
+                for (const uint32_t *l = view->begin(*c); l != view->end(*c) && !sat && unassigned < 2; ++l)
                 {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
+                    if (assigned[ClauseView::gene(*l)] != stamp)
+                    {
+                        unit = *l;
+                        unassigned++;
+                    }
+                    else
+                        sat = ClauseView::satisfied(*l, solution.data());
                 }
+                if (!sat && unassigned == 1)
+                    assign(ClauseView::gene(unit), ClauseView::sign(unit));
             }
         }
+    }
+}
 
-        // Evaluate the fitness of the offspring to compute the unsatisfying variables
-        std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-        for (auto &var : centrality_vars)
-        {
-            // int unsat_var = var.first;
-            // assert(!formula_.fix[var]);
-            if (dist(rng) < mutation_rate_ && !formula_.fix[var])
-            {
-                child1[var] = 1 - child1[var];
-                child2[var] = 1 - child1[var];
-            }
-        }
+// Initialize the population with random solutions
+void GeneticAlgorithm::initialize_population(Island &island)
+{
+    if (init_mode_ == INIT_PROPAGATION)
+    {
+        initialize_propagated(island);
+        return;
+    }
 
-        // Add the offspring to the vector
-        offspring.push_back(std::move(child1));
-        offspring.push_back(std::move(child2));
+    // Create a uniform distribution for integers in [0, 1]
+    std::uniform_int_distribution<int> dist(0, 1);
+
+    int nclauses = formula_.getNumClauses();
+    for (std::size_t i = 0; i < population_size_; i++)
+    {
+        // Create a new solution with random values in its vector (every gene is free, cf. GeneMap)
+        Solution sol(solution_size_, nclauses);
+        assert(sol.size() == solution_size_);
+        for (std::size_t j = 1; j < solution_size_; ++j)
+            sol[j] = dist(island.rng); // generate a random bit using the distribution and the generator
+        island.population.push_back(sol); // Add the solution to the population
     }
+}
 
-    return offspring;
+// One dive per individual from a random chromosome. The individuals are built concurrently, each
+// with its own random stream so that the population does not depend on the number of threads.
+void GeneticAlgorithm::initialize_propagated(Island &island)
+{
+    int nclauses = formula_.getNumClauses();
+    for (std::size_t i = 0; i < population_size_; i++)
+        island.population.push_back(Solution(solution_size_, nclauses));
+
+    uint64_t seed = island.rng();
+    for_each_individual(island, population_size_, [this, &island, seed](std::size_t i)
+                        {
+                            Xoshiro256 rng(seed + i);
+                            Solution &sol = island.population[i];
+                            for (std::size_t w = 0; w < free_mask_.size(); ++w)
+                                sol.setWord(w, rng() & free_mask_[w]);
+                            unit_repair_.dive(sol, rng);
+                        });
 }
 
-Solution GeneticAlgorithm::select_parent(std::mt19937 rng)
+int GeneticAlgorithm::fitness(Solution &solution)
 {
-    // Create a uniform distribution for integers in [0, population_size_ - 1]
-    std::uniform_int_distribution<int> dist(0, population_size_ - 1);
-    int index = dist(rng);
-    return population_[index];
+    int fitness;
+    if (cache_.lookup(cache_key(solution), fitness))
+        return fitness;
+    fitness = score(solution);
+    cache_.insert(cache_key(solution), fitness);
+    return fitness;
 }
 
-std::vector<Solution> GeneticAlgorithm::create_offspring(std::mt19937 rng)
+// Weight of the clauses of the view unsatisfied by the solution, without the cache
+int GeneticAlgorithm::score(const Solution &solution) const
 {
-    // Create a vector to store the offspring solutions
-    std::vector<Solution> offspring;
-    offspring.reserve(population_.size());
+    int fitness = view_.numEmpty();
+    const uint64_t *genes = solution.data();
+    for (std::size_t c = 0; c < view_.numClauses(); ++c)
+        if (!view_.clauseSatisfied(c, genes))
+            fitness += view_.weight(c);
+    return fitness;
+}
 
-    // Create a uniform distribution for floats in [0.0, 1.0]
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    // Create a uniform distribution for integers in [1, solution_size_ - 2]
-    std::uniform_int_distribution<int> dist2(1, solution_size_ - 2);
+// Set the fitness of the individuals of the batch found in the cache and remove them from the batch.
+// Returns the number of hits.
+std::size_t GeneticAlgorithm::lookup_cached(std::vector<Solution *> &batch)
+{
+    std::size_t misses = 0;
+    for (Solution *sol : batch)
+    {
+        int fitness;
+        if (cache_.lookup(cache_key(*sol), fitness))
+            sol->setFitness(fitness);
+        else
+            batch[misses++] = sol;
+    }
+    std::size_t hits = batch.size() - misses;
+    batch.resize(misses);
+    return hits;
+}
 
-    for (std::size_t i = 0; i < population_.size() / 2; i += 2)
+int GeneticAlgorithm::rawFitness(const Solution &solution) const
+{
+    int fitness = view_.numEmpty();
+    const uint64_t *genes = solution.data();
+    for (std::size_t c = 0; c < view_.numOriginal(); ++c)
     {
-        // Select two parents from the vector using their index
-        Solution parent1 = select_parent(rng);
-        Solution parent2 = select_parent(rng);
+        const uint32_t *lit = view_.begin(c);
+        while (lit != view_.end(c) && !ClauseView::satisfied(*lit, genes))
+            ++lit;
+        fitness += lit == view_.end(c);
+    }
+    return fitness;
+}
 
-        Solution child1(parent1);
-        Solution child2(parent2);
+//=================================================================================================
+// Bit-sliced evaluation: the chromosomes of a batch of individuals are transposed so that each gene
+// becomes L 64-bit lane words holding one bit per individual. A clause is then evaluated for the
+// whole batch with OR/XOR operations and the unsatisfied masks are summed in vertical bit-plane
+// counters, without any per-individual branch.
 
-        // Perform crossover with a given probability
-        if (dist(rng) < crossover_rate_)
+// Transpose a 64x64 bit matrix in place: bit b of a[j] becomes bit j of a[b]
+static void transpose64(uint64_t a[64])
+{
+    uint64_t m = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, m ^= m << j)
+    {
+        for (int k = 0; k < 64; k = (k + j + 1) & ~j)
         {
-            // Select a random point to split the solution vector
-            int point = dist2(rng);
-            // std::cout << "point: " << point << std::endl;
+            uint64_t t = ((a[k] >> j) ^ a[k + j]) & m;
+            a[k] ^= t << j;
+            a[k + j] ^= t;
+        }
+    }
+}
 
-            for (int j = 1; j <= point; ++j)
-            {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
-            }
+template <int L>
+static inline __attribute__((always_inline)) void bitslice_kernel(const ClauseView &view, std::size_t first, std::size_t last,
+                                                                  const uint64_t *lanes, const uint64_t *active,
+                                                                  uint64_t *planes, int num_planes)
+{
+    for (std::size_t c = first; c < last; ++c)
+    {
+        uint64_t sat[L] = {0};
+        for (const uint32_t *lit = view.begin(c); lit != view.end(c); ++lit)
+        {
+            // A literal is true where the gene equals its sign: keep the lane for positive signs, invert it otherwise
+            const uint64_t *lane = lanes + (std::size_t)ClauseView::gene(*lit) * L;
+            uint64_t invert = (uint64_t)ClauseView::sign(*lit) - 1;
+            for (int k = 0; k < L; ++k)
+                sat[k] |= lane[k] ^ invert;
         }
 
-        // // Evaluate the fitness of the offspring
-        // child1.setFitness(fitness(child1));
-        // child2.setFitness(fitness(child2));
-
-        // // Perform mutation with a given probability
-        // if (child1.no_unsatisfying_variables())
-        // {
-        //     int mut_var = dist2(rng);
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child1.get_unsatisfying_variables();
-        //     assert(!child1.no_unsatisfying_variables());
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child1[unsat_var] = 1 - child1[unsat_var];
-        //             break;
-        //         }
-        //     }
-        //     // int mut_var = child1.getRandomUnsatisfyingVariable();
-        //     // // std::cout << "mut_var: " << mut_var << std::endl;
-        //     // assert(!formula_.fix[mut_var]);
-        //     // child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        // }
-
-        // if (child2.no_unsatisfying_variables())
-        // {
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         int mut_var = dist2(rng);
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child2[mut_var] = 1 - child2[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     assert(!child2.no_unsatisfying_variables());
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child2.get_unsatisfying_variables();
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child2[unsat_var] = 1 - child2[unsat_var];
-        //         }
-        //     }
-        // }
-        std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-        for (auto &var : centrality_vars)
+        // Add the unsatisfied mask times the clause weight to the bit-plane counters: once per set bit
+        // of the weight, from the plane of that bit (ripple carry, amortized O(1) planes)
+        for (int weight = view.weight(c), first = 0; weight; weight >>= 1, ++first)
         {
-            // int unsat_var = var.first;
-            // assert(!formula_.fix[var]);
-            if (dist(rng) < mutation_rate_ && !formula_.fix[var])
+            if (!(weight & 1))
+                continue;
+            uint64_t carry[L];
+            for (int k = 0; k < L; ++k)
+                carry[k] = ~sat[k] & active[k];
+            for (int p = first; p < num_planes; ++p)
             {
-                child1[var] = 1 - child1[var];
-                child2[var] = 1 - child1[var];
+                uint64_t pending = 0;
+                for (int k = 0; k < L; ++k)
+                {
+                    uint64_t t = planes[p * L + k] & carry[k];
+                    planes[p * L + k] ^= carry[k];
+                    carry[k] = t;
+                    pending |= t;
+                }
+                if (!pending)
+                    break;
             }
         }
-
-        // Add the offspring to the vector
-        offspring.push_back(std::move(child1));
-        offspring.push_back(std::move(child2));
     }
+}
+
+typedef void (*BitsliceKernel)(const ClauseView &, std::size_t, std::size_t, const uint64_t *, const uint64_t *, uint64_t *, int);
 
-    return offspring;
+static void bitslice_kernel_64(const ClauseView &view, std::size_t first, std::size_t last, const uint64_t *lanes,
+                               const uint64_t *active, uint64_t *planes, int num_planes)
+{
+    bitslice_kernel<1>(view, first, last, lanes, active, planes, num_planes);
 }
 
-std::vector<Solution> GeneticAlgorithm::create_offspring_two_points(std::mt19937 rng)
+static void bitslice_kernel_128(const ClauseView &view, std::size_t first, std::size_t last, const uint64_t *lanes,
+                                const uint64_t *active, uint64_t *planes, int num_planes)
 {
-    // Create a vector to store the offspring solutions
-    std::vector<Solution> offspring;
-    offspring.reserve(population_.size());
+    bitslice_kernel<2>(view, first, last, lanes, active, planes, num_planes);
+}
 
-    // Create a uniform distribution for floats in [0.0, 1.0]
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    // Create a uniform distribution for integers in [1, solution_size_ - 2]
-    std::uniform_int_distribution<int> dist2(1, solution_size_ - 2);
+// The wider kernels are compiled for AVX2 and AVX-512 and only picked when the CPU has them, other
+// architectures stop at 128 lanes
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static void bitslice_kernel_256(const ClauseView &view, std::size_t first, std::size_t last,
+                                                                const uint64_t *lanes, const uint64_t *active,
+                                                                uint64_t *planes, int num_planes)
+{
+    bitslice_kernel<4>(view, first, last, lanes, active, planes, num_planes);
+}
+
+__attribute__((target("avx512f"))) static void bitslice_kernel_512(const ClauseView &view, std::size_t first, std::size_t last,
+                                                                   const uint64_t *lanes, const uint64_t *active,
+                                                                   uint64_t *planes, int num_planes)
+{
+    bitslice_kernel<8>(view, first, last, lanes, active, planes, num_planes);
+}
+#endif
 
-    for (size_t i = 0; i < population_.size() / 2; i++)
+// Widest lane count (in 64-bit words) supported by the CPU we are running on
+static int bitslice_max_words()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    static const int max_words = __builtin_cpu_supports("avx512f") ? 8 : __builtin_cpu_supports("avx2") ? 4
+                                                                                                        : 2;
+    return max_words;
+#else
+    return 2;
+#endif
+}
+
+// Kernel for L words of lanes, L being at most bitslice_max_words()
+static BitsliceKernel bitslice_kernel_for(int L)
+{
+    switch (L)
     {
-        // Select two parents from the vector using their index
-        Solution parent1 = select_parent(rng);
-        Solution parent2 = select_parent(rng);
+    case 1:
+        return bitslice_kernel_64;
+    case 2:
+        return bitslice_kernel_128;
+#if defined(__x86_64__) || defined(__i386__)
+    case 4:
+        return bitslice_kernel_256;
+    default:
+        return bitslice_kernel_512;
+#else
+    default:
+        return bitslice_kernel_128;
+#endif
+    }
+}
 
-        Solution child1(parent1);
-        Solution child2(parent2);
+// Score a batch of individuals missing from the cache
+void GeneticAlgorithm::evaluate_bitsliced(Island &island, std::vector<Solution *> &batch)
+{
+    int num_planes = 1;
+    while (num_planes < 31 && (int64_t(1) << num_planes) <= view_.totalWeight())
+        num_planes++;
 
-        // Perform crossover with a given probability
-        if (dist(rng) < crossover_rate_)
+    const std::size_t nwords = Solution::num_words(solution_size_);
+    std::size_t done = 0;
+    while (done < batch.size())
+    {
+        // Use the narrowest kernel that holds the remaining individuals
+        std::size_t remaining = batch.size() - done;
+        int L = 1;
+        while (L < bitslice_max_words() && (std::size_t)L * 64 < remaining)
+            L *= 2;
+        BitsliceKernel kernel = bitslice_kernel_for(L);
+        std::size_t count = std::min(remaining, (std::size_t)L * 64);
+
+        // Transpose the chromosomes, 64 individuals by 64 genes at a time
+        island.lanes.assign(nwords * 64 * L, 0);
+        std::vector<uint64_t> active(L, 0);
+        uint64_t block[64];
+        for (int k = 0; k < L; ++k)
         {
-            // Select a random point to split the solution vector
-            int point1 = dist2(rng);
-            int point2 = dist2(rng);
-            if (point1 > point2)
-            {
-                std::swap(point1, point2);
-            }
-            for (int j = 1; j <= point1; ++j)
+            std::size_t base = done + (std::size_t)k * 64;
+            std::size_t n = base < done + count ? std::min<std::size_t>(64, done + count - base) : 0;
+            active[k] = n == 64 ? ~0ULL : (1ULL << n) - 1;
+            if (n == 0)
+                continue;
+            for (std::size_t w = 0; w < nwords; ++w)
             {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
-            }
-            for (int j = point2; j < solution_size_; ++j)
-            {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
+                for (std::size_t b = 0; b < 64; ++b)
+                    block[b] = b < n ? batch[base + b]->data()[w] : 0;
+                transpose64(block);
+                for (std::size_t j = 0; j < 64; ++j)
+                    island.lanes[(w * 64 + j) * L + k] = block[j];
             }
         }
 
-        // Evaluate the fitness of the offspring
-
-        // child1.setFitness(fitness(child1));
-        // child2.setFitness(fitness(child2));
-
-        // // Perform mutation with a given probability
-        // if (child1.no_unsatisfying_variables())
-        // {
-        //     int mut_var = dist2(rng);
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child1.get_unsatisfying_variables();
-        //     assert(!child1.no_unsatisfying_variables());
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child1[unsat_var] = 1 - child1[unsat_var];
-        //             break;
-        //         }
-        //     }
-        //     // int mut_var = child1.getRandomUnsatisfyingVariable();
-        //     // // std::cout << "mut_var: " << mut_var << std::endl;
-        //     // assert(!formula_.fix[mut_var]);
-        //     // child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        // }
-
-        // if (child2.no_unsatisfying_variables())
-        // {
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         int mut_var = dist2(rng);
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child2[mut_var] = 1 - child2[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     assert(!child2.no_unsatisfying_variables());
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child2.get_unsatisfying_variables();
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child2[unsat_var] = 1 - child2[unsat_var];
-        //         }
-        //     }
-        // }
-
-        std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-        for (auto &var : centrality_vars)
+        // Split the clauses in chunks, each with its own counters, and add the counts up
+        std::size_t nchunks = island.pool ? island.pool->size() : 1;
+        std::size_t chunk = (view_.numClauses() + nchunks - 1) / nchunks;
+        std::vector<std::vector<int>> counts(nchunks, std::vector<int>(count, 0));
+        for_each_individual(island, nchunks, [&](std::size_t t)
+                            {
+                                std::size_t first = std::min(view_.numClauses(), t * chunk);
+                                std::size_t last = std::min(view_.numClauses(), first + chunk);
+                                std::vector<uint64_t> planes((std::size_t)num_planes * L, 0);
+                                kernel(view_, first, last, island.lanes.data(), active.data(), planes.data(), num_planes);
+                                for (std::size_t i = 0; i < count; ++i)
+                                    for (int p = 0; p < num_planes; ++p)
+                                        counts[t][i] += (int)((planes[p * L + i / 64] >> (i & 63)) & 1) << p;
+                            });
+
+        for (std::size_t i = 0; i < count; ++i)
         {
-            // int unsat_var = var.first;
-            // assert(!formula_.fix[var]);
-            if (dist(rng) < mutation_rate_ && !formula_.fix[var])
-            {
-                child1[var] = 1 - child1[var];
-                child2[var] = 1 - child1[var];
-            }
+            int fitness = view_.numEmpty();
+            for (std::size_t t = 0; t < nchunks; ++t)
+                fitness += counts[t][i];
+            batch[done + i]->setFitness(fitness);
+            cache_.insert(cache_key(*batch[done + i]), fitness);
         }
+        done += count;
+    }
+}
+
+// Run body(i) for every individual index, on the island's thread pool if it has one
+void GeneticAlgorithm::for_each_individual(Island &island, std::size_t n, const std::function<void(std::size_t)> &body)
+{
+    if (island.pool)
+        island.pool->parallel_for(n, body);
+    else
+        for (std::size_t i = 0; i < n; ++i)
+            body(i);
+}
+
+// Evaluate the fitness of each solution in the population
+void GeneticAlgorithm::evaluate_fitness(Island &island)
+{
+    if (bitsliced_ && !incremental_)
+    {
+        island.batch.clear();
+        for (std::size_t i = 0; i < population_size_; ++i)
+            island.batch.push_back(&island.population[i]);
+        lookup_cached(island.batch); // Individuals found in the cache do not need to be transposed
+        evaluate_bitsliced(island, island.batch);
+        island.population.sort();
+        island.evaluations.full += population_size_;
+        return;
+    }
+    island.evaluations.full += population_size_;
+    for_each_individual(island, population_size_, [this, &island](std::size_t i)
+                        {
+                            assert(island.population[i].size() == solution_size_);
+                            // Evaluate the fitness of each solution using the fitness function
+                            if (incremental_)
+                                evaluator_.init(island.population[i]);
+                            else
+                                island.population[i].setFitness(fitness(island.population[i]));
+                        });
+    // Sort the population by fitness in descending order (best solutions first)
+    island.population.sort();
+}
+// A delta evaluation visits the clauses of the changed genes: it pays off when they are few compared
+// to a full evaluation. Without counters, each of these clauses is scanned before and after the changes.
+bool GeneticAlgorithm::delta_worthwhile(const Solution &solution) const
+{
+    std::size_t visits = evaluator_.changed_occurrences(solution);
+    if (incremental_ && solution.hasTrueCounts())
+        return 2 * visits < view_.numLiterals();
+    return 4 * visits < view_.numClauses();
+}
 
-        // Add the offspring to the vector
-        offspring.push_back(std::move(child1));
-        offspring.push_back(std::move(child2));
+// Evaluate the fitness of the offspring: children identical to their parent keep its fitness, those
+// with few changed genes get a delta evaluation and the others a full one
+void GeneticAlgorithm::evaluate_fitness(Island &island, std::vector<Solution> &offspring, std::size_t count)
+{
+    EvaluationCounts &counts = island.last_evaluations;
+    counts = EvaluationCounts();
+    island.batch.clear();
+    island.updates.clear();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!offspring[i].changed())
+            counts.inherited++;
+        else if (delta_worthwhile(offspring[i]))
+            island.updates.push_back(&offspring[i]);
+        else
+            island.batch.push_back(&offspring[i]);
     }
-    return offspring;
+    counts.delta = island.updates.size();
+    counts.full = island.batch.size();
+    if (!incremental_)
+        counts.cached = lookup_cached(island.batch);
+    island.evaluations += counts;
+
+    for_each_individual(island, island.updates.size(), [this, &island](std::size_t i)
+                        {
+                            Solution &sol = *island.updates[i];
+                            if (incremental_ && sol.hasTrueCounts())
+                                evaluator_.apply_changes(sol);
+                            else
+                                sol.setFitness(evaluator_.delta(sol));
+                        });
+    if (bitsliced_ && !incremental_)
+    {
+        evaluate_bitsliced(island, island.batch);
+        return;
+    }
+    for_each_individual(island, island.batch.size(), [this, &island](std::size_t i)
+                        {
+                            Solution &sol = *island.batch[i];
+                            if (incremental_)
+                                evaluator_.init(sol);
+                            else
+                            {
+                                sol.setFitness(score(sol));
+                                cache_.insert(cache_key(sol), sol.getFitness());
+                            }
+                        });
+}
+
+// Memetic step: improve the children (or only those fit enough to join the elite) by local search
+void GeneticAlgorithm::improve_offspring(Island &island, std::size_t count)
+{
+    int threshold = island.population[std::max<std::size_t>(population_size_ / 2, 1) - 1].getFitness();
+    // One stream per child keeps the result independent of the thread that improves it
+    uint64_t seed = island.rng();
+    for_each_individual(island, count, [this, &island, threshold, seed](std::size_t i)
+                        {
+                            Solution &child = island.offspring[i];
+                            if (ls_elite_only_ && child.getFitness() > threshold)
+                                return;
+                            Xoshiro256 rng(seed + i);
+                            local_search_.improve(child, ls_steps_, rng);
+                            cache_.insert(cache_key(child), child.getFitness());
+                        });
 }
 
-// Create offspring through two points crossover and mutation
-std::vector<Solution> GeneticAlgorithm::create_offspring_two_points(const std::vector<Solution> &parents, std::mt19937 rng)
+// Repair the children that differ from their parent, an unchanged one is as consistent as its parent
+void GeneticAlgorithm::repair_offspring(Island &island, std::size_t count)
 {
-    // Create a vector to store the offspring solutions
-    std::vector<Solution> offspring;
-    offspring.reserve(parents.size());
+    for_each_individual(island, count, [this, &island](std::size_t i)
+                        {
+                            if (island.offspring[i].changed())
+                                unit_repair_.repair(island.offspring[i]);
+                        });
+}
+
+// Mark the genes that the genetic operators are allowed to change: all of them but the unused gene 0,
+// since fixed variables have no gene
+void GeneticAlgorithm::build_free_mask()
+{
+    free_mask_.assign(Solution::num_words(solution_size_), 0);
+    for (std::size_t j = 1; j < solution_size_; ++j)
+        free_mask_[Solution::word_index(j)] |= Solution::bit_mask(j);
+
+    // Degree centrality variables are listed as variable + 1, keep those that still have a gene
+    centrality_genes_.clear();
+    for (unsigned v : formula_.get_degree_centrality_variables())
+        if (v >= 1 && genes_.gene(v - 1) != 0)
+            centrality_genes_.push_back(genes_.gene(v - 1));
+
+    // Genes exchanged by the mask crossover
+    centrality_mask_.assign(free_mask_.size(), 0);
+    for (unsigned g : centrality_genes_)
+        centrality_mask_[Solution::word_index(g)] |= Solution::bit_mask(g);
+}
+
+// One generation of offspring: pick parents with the selection policy, exchange the genes chosen by
+// the crossover policy and flip the genes chosen by the mutation policy. Both operators work on whole
+// words restricted to the free genes, the policies only say which bits are concerned. The children
+// log the words that changed, evaluate_fitness() then brings their fitness (and counters) up to date.
+template <class Selection, class Crossover, class Mutation>
+std::size_t GeneticAlgorithm::breed(Island &island)
+{
+    Xoshiro256 &rng = island.rng;
+    Stopwatch watch(telemetry_ != nullptr);
+    Selection::select(island.population, population_size_, island.parents, rng);
+    island.times.selection += watch.lap();
+    const std::vector<std::size_t> &parents = island.parents;
 
     // Create a uniform distribution for floats in [0.0, 1.0]
     std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    // Create a uniform distribution for integers in [1, solution_size_ - 2]
-    std::uniform_int_distribution<int> dist2(1, solution_size_ - 2);
-    // Create a uniform distribution for integers in [0, parents.size() - 1]
-    std::uniform_int_distribution<int> dist3(0, parents.size() - 1);
+    Crossover crossover(solution_size_, centrality_mask_);
+    Mutation mutation(mutation_rate_, mutation_per_chromosome_, centrality_genes_, free_mask_, solution_size_);
+    const std::size_t nwords = free_mask_.size();
 
-    for (std::size_t i = 0; i < parents.size() - 1; i += 2)
+    // Children are written into the preallocated offspring buffer
+    std::size_t noffspring = 0;
+    for (std::size_t i = 0; i + 1 < parents.size(); i += 2)
     {
         // Select two parents from the vector using their index
-        Solution parent1 = parents[i];
-        Solution parent2 = parents[i + 1];
-        // Solution parent1 = parents[dist3(rng)];
-        // Solution parent2 = parents[dist3(rng)];
+        const Solution &parent1 = island.population[parents[i]];
+        const Solution &parent2 = island.population[parents[i + 1]];
 
-        Solution child1(parent1);
-        Solution child2(parent2);
+        Solution &child1 = island.offspring[noffspring++];
+        Solution &child2 = island.offspring[noffspring++];
+        child1 = parent1;
+        child2 = parent2;
 
-        // Perform crossover with a given probability
+        // Perform crossover with a given probability: the children swap the selected genes
         if (dist(rng) < crossover_rate_)
         {
-            // Select a random point to split the solution vector
-            int point1 = dist2(rng);
-            int point2 = dist2(rng);
-            if (point1 > point2)
-            {
-                std::swap(point1, point2);
-            }
-            for (int j = 1; j <= point1; ++j)
+            crossover.draw(rng);
+            for (std::size_t w = 0; w < nwords; ++w)
             {
-                if (!formula_.fix[j])
+                uint64_t diff = (parent1.getWord(w) ^ parent2.getWord(w)) & crossover.mask(w) & free_mask_[w];
+                if (diff)
                 {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
+                    child1.setWord(w, child1.getWord(w) ^ diff);
+                    child2.setWord(w, child2.getWord(w) ^ diff);
                 }
             }
-            for (int j = point2; j < solution_size_; ++j)
+        }
+        island.times.crossover += watch.lap();
+
+        // Perform mutation: the same genes are flipped in both children
+        if (mutation.draw(island.mutation_mask, rng))
+        {
+            for (std::size_t w = 0; w < nwords; ++w)
             {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
+                uint64_t mask = island.mutation_mask[w] & free_mask_[w];
+                island.mutation_mask[w] = 0;
+                if (!mask)
+                    continue;
+                child1.setWord(w, child1.getWord(w) ^ mask);
+                child2.setWord(w, child2.getWord(w) ^ mask);
             }
         }
+        island.times.mutation += watch.lap();
+    }
 
-        // // Evaluate the fitness of the offspring
-        // child1.setFitness(fitness(child1));
-        // child2.setFitness(fitness(child2));
-
-        // // Perform mutation with a given probability
-        // if (child1.no_unsatisfying_variables())
-        // {
-        //     int mut_var = dist2(rng);
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child1.get_unsatisfying_variables();
-        //     assert(!child1.no_unsatisfying_variables());
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child1[unsat_var] = 1 - child1[unsat_var];
-        //             break;
-        //         }
-        //     }
-        //     // int mut_var = child1.getRandomUnsatisfyingVariable();
-        //     // // std::cout << "mut_var: " << mut_var << std::endl;
-        //     // assert(!formula_.fix[mut_var]);
-        //     // child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        // }
-
-        // if (child2.no_unsatisfying_variables())
-        // {
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         int mut_var = dist2(rng);
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child2[mut_var] = 1 - child2[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     assert(!child2.no_unsatisfying_variables());
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child2.get_unsatisfying_variables();
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child2[unsat_var] = 1 - child2[unsat_var];
-        //         }
-        //     }
-        // }
-        std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-        for (auto &var : centrality_vars)
+    return noffspring;
+}
+
+// Instantiate the pipeline for the operators selected at run time
+template <class Selection, class Crossover>
+GeneticAlgorithm::Breeder GeneticAlgorithm::breeder_for(int mutation)
+{
+    if (mutation == MUTATE_ALL)
+        return &GeneticAlgorithm::breed<Selection, Crossover, UniformMutation>;
+    return &GeneticAlgorithm::breed<Selection, Crossover, CentralityMutation>;
+}
+
+template <class Selection>
+GeneticAlgorithm::Breeder GeneticAlgorithm::breeder_for(int crossover, int mutation)
+{
+    switch (crossover)
+    {
+    case CROSSOVER_TWO_POINTS:
+        return breeder_for<Selection, TwoPointCrossover>(mutation);
+    case CROSSOVER_THREE_POINTS:
+        return breeder_for<Selection, ThreePointCrossover>(mutation);
+    case CROSSOVER_UNIFORM:
+        return breeder_for<Selection, UniformCrossover>(mutation);
+    case CROSSOVER_MASK:
+        return breeder_for<Selection, MaskCrossover>(mutation);
+    default:
+        return breeder_for<Selection, OnePointCrossover>(mutation);
+    }
+}
+
+GeneticAlgorithm::Breeder GeneticAlgorithm::breeder(int selection, int crossover, int mutation)
+{
+    if (selection == SELECT_RANDOM)
+        return breeder_for<RandomSelection>(crossover, mutation);
+    return breeder_for<TournamentSelection>(crossover, mutation);
+}
+
+// Collect the indices of the population (0 .. population_size_ - 1) and of the offspring
+// (population_size_ .. ) in island.order, skipping individuals whose chromosome hash was already seen.
+// At most noffspring duplicates are dropped so that enough candidates remain.
+void GeneticAlgorithm::collect_candidates(Island &island, std::size_t noffspring)
+{
+    std::size_t ncombined = population_size_ + noffspring;
+    std::size_t table_size = 4;
+    while (table_size < 2 * ncombined)
+        table_size <<= 1;
+    if (island.seen.size() < table_size)
+    {
+        island.seen.assign(table_size, ChromosomeHash());
+        island.seen_stamp.assign(table_size, 0);
+        island.stamp = 0;
+    }
+    island.stamp++;
+    const std::size_t mask = island.seen.size() - 1;
+
+    island.order.clear();
+    std::size_t maxErasures = noffspring; // Maximum allowed erasures
+    for (std::size_t i = 0; i < ncombined; ++i)
+    {
+        const ChromosomeHash &h = combined(island, i).getHash();
+        std::size_t slot = h.lo & mask;
+        bool duplicate = false;
+        for (; island.seen_stamp[slot] == island.stamp; slot = (slot + 1) & mask)
         {
-            // int unsat_var = var.first;
-            // assert(!formula_.fix[var]);
-            if (dist(rng) < mutation_rate_ && !formula_.fix[var])
+            if (island.seen[slot] == h)
             {
-                child1[var] = 1 - child1[var];
-                child2[var] = 1 - child1[var];
+                duplicate = true;
+                break;
             }
         }
+        if (duplicate && maxErasures > 0)
+        {
+            maxErasures--;
+            continue;
+        }
+        if (!duplicate)
+        {
+            island.seen[slot] = h;
+            island.seen_stamp[slot] = island.stamp;
+        }
+        island.order.push_back(i);
+    }
+    assert(island.order.size() >= population_size_);
+}
+
+// Move the candidates order[0 .. elite) to the front, best first, in O(n + elite log elite)
+void GeneticAlgorithm::select_elite(Island &island, std::size_t elite)
+{
+    auto by_fitness = [this, &island](std::size_t i1, std::size_t i2)
+    { return combined(island, i1).getFitness() < combined(island, i2).getFitness(); };
+    if (elite == 0)
+        return;
+    if (elite < island.order.size())
+        std::nth_element(island.order.begin(), island.order.begin() + elite - 1, island.order.end(), by_fitness);
+    std::sort(island.order.begin(), island.order.begin() + elite, by_fitness);
+}
 
-        // Add the offspring to the vector
-        offspring.push_back(std::move(child1));
-        offspring.push_back(std::move(child2));
+// Move the selected individuals into the spare population buffer and make it the live one.
+// Solutions are swapped rather than copied, the slots they leave behind are reused as buffers.
+void GeneticAlgorithm::install_survivors(Island &island, std::size_t count)
+{
+    for (std::size_t k = 0; k < count; ++k)
+        std::swap(island.next_population[k], combined(island, island.order[k]));
+    island.population.swap(island.next_population);
+}
+
+// Select the best solutions to survive to the next generation
+void GeneticAlgorithm::select_survivors_ellitist(Island &island, std::size_t noffspring)
+{
+    collect_candidates(island, noffspring);
+
+    // Select the 50% best and 50% worst solutions to survive
+    size_t nbest = population_size_ / 2;
+    size_t nworst = population_size_ - nbest;
+    select_elite(island, nbest);
+
+    // The others are drawn uniformly from the remaining candidates (partial Fisher-Yates shuffle)
+    for (std::size_t k = nbest; k < nbest + nworst; ++k)
+    {
+        std::uniform_int_distribution<std::size_t> dist(k, island.order.size() - 1);
+        std::swap(island.order[k], island.order[dist(island.rng)]);
     }
+    install_survivors(island, nbest + nworst);
+    assert(island.population.size() == population_size_);
+}
+
+// Check if a satisfactory solution has been found
+bool GeneticAlgorithm::solution_found(Island &island)
+{
+    // Check if the fittest solution satisfies all the clauses
+    Solution &fittest = island.population[0];
+    return objective(fittest) == 0;
+}
 
-    return offspring;
+// Create the islands, each with its own random stream and operators. Unless a crossover was chosen,
+// the islands cycle through the one, two and three points crossovers (island 0 uses one point).
+// The streams are jumps of one generator: the ranks of a job are long jumps apart, the islands of a
+// rank jumps apart, and the migrations use the stream after the last island.
+void GeneticAlgorithm::create_islands()
+{
+    Xoshiro256 rng(seed_ >= 0 ? (uint64_t)seed_ + runs_ : (uint64_t)std::random_device()() << 32 ^ std::random_device()());
+    runs_++;
+    for (int r = gaspi_ ? gaspi_->rank() : 0; r > 0; --r)
+        rng.long_jump();
+    islands_.clear();
+    islands_.reserve(num_islands_);
+    for (std::size_t k = 0; k < num_islands_; ++k)
+    {
+        islands_.emplace_back(population_size_);
+        Island &island = islands_.back();
+        island.rng = rng;
+        rng.jump();
+        int crossover = crossover_ != CROSSOVER_CYCLE ? crossover_ : CROSSOVER_ONE_POINT + (int)(k % 3);
+        island.breed = breeder(selection_, crossover, mutation_);
+        island.mutation_mask.assign(free_mask_.size(), 0);
+        // Concurrent islands evaluate their individuals sequentially, the pool is busy running islands
+        island.pool = num_islands_ > 1 ? nullptr : pool_.get();
+    }
+    migration_rng_ = rng;
 }
 
-// Create offspring through three points crossover and mutation
-std::vector<Solution> GeneticAlgorithm::create_offspring_three_points(const std::vector<Solution> &parents, std::mt19937 rng)
+// Evaluate the new population of an island and allocate its generation buffers once: copies of an
+// evaluated individual already have the capacity needed for the chromosome and counters
+void GeneticAlgorithm::prepare_island(Island &island)
 {
-    // Create a vector to store the offspring solutions
-    std::vector<Solution> offspring;
-    offspring.reserve(parents.size());
+    if (repair_)
+        for_each_individual(island, population_size_, [this, &island](std::size_t i)
+                            { unit_repair_.repair(island.population[i]); });
+    evaluate_fitness(island);
+    island.parents.reserve(population_size_);
+    island.order.reserve(2 * population_size_ + 1);
+    island.offspring.assign(population_size_ + 1, island.population[0]);
+    island.next_population = island.population;
+}
 
-    // Create a uniform distribution for floats in [0.0, 1.0]
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    // Create a uniform distribution for integers in [1, solution_size_ - 2]
-    std::uniform_int_distribution<int> dist2(1, solution_size_ - 2);
-    // Create a uniform distribution for integers in [0, parents.size() - 1]
-    std::uniform_int_distribution<int> dist3(0, parents.size() - 1);
+// Evolve the prepared islands for up to max_generations generations and return the best solution
+Solution GeneticAlgorithm::run(int max_generations)
+{
+    for (Island &island : islands_)
+    {
+        if (solution_found(island))
+            stop(STOP_SOLVED);
+        publish_best(island);
+    }
 
-    for (std::size_t i = 0; i < parents.size() - 1; i += 2)
+    // The islands run independently between two migrations (or clause weight updates)
+    bool migrating = islands_.size() > 1 || (gaspi_ && gaspi_->size() > 1);
+    int interval = migrating && migration_interval_ > 0 ? migration_interval_ : weight_interval_ > 0 ? weight_interval_ : max_generations;
+    for (int iteration = 0; iteration < max_generations && !stopped(); iteration += interval)
     {
-        // Select two parents from the vector using their index
-        Solution parent1 = parents[i];
-        Solution parent2 = parents[i + 1];
-        // Solution parent1 = parents[dist3(rng)];
-        // Solution parent2 = parents[dist3(rng)];
+        int generations = std::min(interval, max_generations - iteration);
+        for_each_island([this, generations](Island &island)
+                        { evolve(island, generations); });
+        if (gaspi_)
+            exchange();
+        if (stagnated())
+            stop(STOP_STAGNATION);
+        if (!stopped())
+            migrate();
+        if (!stopped() && weight_interval_ > 0)
+            update_weights();
+    }
+    stop(STOP_GENERATIONS);
 
-        Solution child1(parent1);
-        Solution child2(parent2);
+    if (gaspi_)
+        return gather();
+    return getBestSolution();
+}
 
-        // Perform crossover with a given probability
-        if (dist(rng) < crossover_rate_)
-        {
-            // Select a random point to split the solution vector
-            int point1 = dist2(rng);
-            int point2 = dist2(rng);
-            int point3 = dist2(rng);
+Solution GeneticAlgorithm::refine(const std::vector<Solution> &seeds, int generations)
+{
+    start_time_ = std::chrono::steady_clock::now();
+    restart();
+    if (learnt_tiers_ > 0)
+        update_learnts();
+    create_islands();
+    for_each_island([this, &seeds](Island &island)
+                    {
+                        seed_population(island, seeds);
+                        prepare_island(island);
+                    });
+    return run(generations);
+}
 
-            // sort the points
-            if (point1 > point2)
-            {
-                std::swap(point1, point2);
-            }
-            if (point2 > point3)
-            {
-                std::swap(point2, point3);
-            }
-            if (point1 > point2)
-            {
-                std::swap(point1, point2);
-            }
+// Replace the learnt clauses of the view by the current ones of the solver. The fitness function
+// changes, so the cached values and the occurrence index have to go.
+void GeneticAlgorithm::update_learnts()
+{
+    view_.clear_learnts();
+    view_.add_learnts(solver_, genes_, solver_.getCoreLearnts(), CORE, learnt_weight_);
+    if (learnt_tiers_ >= 2)
+        view_.add_learnts(solver_, genes_, solver_.getTier2Learnts(), TIER2, learnt_weight_);
+    if (evaluator_.ready())
+        evaluator_.build(view_, solution_size_);
+    cache_epoch_++;
+}
 
-            for (int j = 1; j <= point1; ++j)
-            {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
-            }
-            for (int j = point2; j <= point3; ++j)
-            {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
-            }
-        }
+// Clause weighting in the style of PAWS: the clauses unsatisfied by the fittest individual of an
+// island gain one unit of weight, and every 'weight_smoothing' updates the weights above their base
+// lose one. The individuals are then rescored from the changed clauses only, with their counters
+// when they have some.
+static const int weight_smoothing = 10;
+
+void GeneticAlgorithm::update_weights()
+{
+    bool smooth = ++weight_updates_ % weight_smoothing == 0;
+    auto satisfies = [this](const Solution &solution, std::size_t c)
+    {
+        if (incremental_ && solution.hasTrueCounts())
+            return solution.getTrueCounts()[c] > 0;
+        return view_.clauseSatisfied(c, solution.data());
+    };
 
-        // Evaluate the fitness of the offspring
-        // child1.setFitness(fitness(child1));
-        // child2.setFitness(fitness(child2));
-
-        // Perform mutation with a given probability
-        // if (child1.no_unsatisfying_variables())
-        // {
-        //     int mut_var = dist2(rng);
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        // std::vector<std::pair<int, int>> unsat_vars = child1.get_unsatisfying_variables();
-        // assert(!child1.no_unsatisfying_variables());
-        std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-        for (auto &var : centrality_vars)
+    weight_deltas_.clear();
+    for (std::size_t c = 0; c < view_.numClauses(); ++c)
+    {
+        bool hard = false;
+        for (std::size_t k = 0; k < islands_.size() && !hard; ++k)
+            hard = !satisfies(islands_[k].population[0], c);
+        int delta = (int)hard - (int)(smooth && view_.weight(c) > view_.baseWeight(c));
+        if (delta != 0)
         {
-            // int unsat_var = var.first;
-            // assert(!formula_.fix[var]);
-            if (dist(rng) < mutation_rate_ && !formula_.fix[var])
-            {
-                child1[var] = 1 - child1[var];
-                child2[var] = 1 - child1[var];
-            }
+            view_.addWeight(c, delta);
+            weight_deltas_.push_back(std::make_pair((uint32_t)c, delta));
         }
-        // int mut_var = child1.getRandomUnsatisfyingVariable();
-        // // std::cout << "mut_var: " << mut_var << std::endl;
-        // assert(!formula_.fix[mut_var]);
-        // child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        // }
-
-        // if (child2.no_unsatisfying_variables())
-        // {
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         int mut_var = dist2(rng);
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child2[mut_var] = 1 - child2[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        // assert(!child2.no_unsatisfying_variables());
-
-        // std::vector<std::pair<int, int>> unsat_vars = child2.get_unsatisfying_variables();
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child2[unsat_var] = 1 - child2[unsat_var];
-        //         }
-        //     }
-        // }
-        // std::vector<int> centrality_vars = formula_.get_degree_centrality_variables();
-
-        // Add the offspring to the vector
-        offspring.push_back(std::move(child1));
-        offspring.push_back(std::move(child2));
     }
+    if (weight_deltas_.empty())
+        return;
+
+    for_each_island([this, &satisfies](Island &island)
+                    {
+                        for (std::size_t i = 0; i < population_size_; ++i)
+                        {
+                            Solution &solution = island.population[i];
+                            int fitness = solution.getFitness();
+                            for (const std::pair<uint32_t, int> &change : weight_deltas_)
+                                if (!satisfies(solution, change.first))
+                                    fitness += change.second;
+                            solution.setFitness(fitness);
+                        }
+                        island.population.sort();
+                        island.best_fitness = island.population[0].getFitness();
+                    });
+    cache_epoch_++;
+}
 
-    return offspring;
+// Hand the best individual of an island to the solver searching meanwhile, compared by raw fitness
+// since the weighted one changes with the weights
+void GeneticAlgorithm::publish_best(Island &island)
+{
+    if (!phases_)
+        return;
+    Solution &best = island.population[0];
+    phases_->publish(best, objective(best));
 }
 
-// Create offspring through three points crossover and mutation
-std::vector<Solution> GeneticAlgorithm::create_offspring_three_points(std::mt19937 rng)
+// The seeds, then copies of them with each gene flipped with probability 1/32
+void GeneticAlgorithm::seed_population(Island &island, const std::vector<Solution> &seeds)
 {
-    // Create a vector to store the offspring solutions
-    std::vector<Solution> offspring;
-    offspring.reserve(population_.size());
+    GeometricSkip skip(1.0 / 32);
+    for (std::size_t i = 0; i < population_size_; ++i)
+    {
+        Solution sol(seeds[i % seeds.size()]);
+        for (std::size_t j = 1; i >= seeds.size(); ++j)
+        {
+            j += skip.next(island.rng, solution_size_ - j);
+            if (j >= solution_size_)
+                break;
+            sol[j] = sol.get(j) ^ 1;
+        }
+        island.population.push_back(sol);
+    }
+}
 
-    // Create a uniform distribution for floats in [0.0, 1.0]
-    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
-    // Create a uniform distribution for integers in [1, solution_size_ - 2]
-    std::uniform_int_distribution<int> dist2(1, solution_size_ - 2);
+// Run body on every island, concurrently if a thread pool was configured
+void GeneticAlgorithm::for_each_island(const std::function<void(Island &)> &body)
+{
+    if (pool_ && islands_.size() > 1)
+        pool_->parallel_for(islands_.size(), [this, &body](std::size_t k)
+                            { body(islands_[k]); });
+    else
+        for (Island &island : islands_)
+            body(island);
+}
 
-    for (std::size_t i = 0; i < population_.size() / 2; i += 2)
+// Run up to 'generations' generations on one island, stopping as soon as the search is over or the
+// island stagnates
+void GeneticAlgorithm::evolve(Island &island, int generations)
+{
+    for (int iteration = 0; iteration < generations && !stopped(); ++iteration)
     {
-        // Select two parents from the vector using their index
-        Solution parent1 = select_parent(rng);
-        Solution parent2 = select_parent(rng);
-        Solution child1(parent1);
-        Solution child2(parent2);
-
-        // Perform crossover with a given probability
-        if (dist(rng) < crossover_rate_)
+        // Migrants may have improved the island since its last generation
+        if (island.population[0].getFitness() < island.best_fitness)
         {
-            // Select a random point to split the solution vector
-            int point1 = dist2(rng);
-            int point2 = dist2(rng);
-            int point3 = dist2(rng);
+            island.best_fitness = island.population[0].getFitness();
+            island.stalled = 0;
+        }
+        if (stagnation_limit_ > 0 && island.stalled >= stagnation_limit_)
+            break;
+
+        island.times = GenerationTimes();
+        std::size_t noffspring = (this->*island.breed)(island);
+        Stopwatch watch(telemetry_ != nullptr);
+        if (repair_)
+            repair_offspring(island, noffspring);
+        island.times.improvement += watch.lap();
+
+        evaluate_fitness(island, island.offspring, noffspring);
+        island.times.evaluation += watch.lap();
+        if (ls_steps_ > 0)
+            improve_offspring(island, noffspring);
+        island.times.improvement += watch.lap();
+        select_survivors_ellitist(island, noffspring);
+        island.times.selection += watch.lap();
+
+        island.generations++;
+        island.stalled++;
+        publish_best(island);
+        if (telemetry_)
+            record(island);
+
+        // Check if a solution has been found
+        if (solution_found(island))
+            stop(STOP_SOLVED);
+        if (time_limit_ > 0 && elapsed() >= time_limit_)
+            stop(STOP_TIME);
+    }
+}
 
-            // sort the points
-            if (point1 > point2)
-            {
-                std::swap(point1, point2);
-            }
-            if (point2 > point3)
-            {
-                std::swap(point2, point3);
-            }
-            if (point1 > point2)
-            {
-                std::swap(point1, point2);
-            }
+// Hand the statistics of the generation the island just completed to the telemetry
+void GeneticAlgorithm::record(Island &island)
+{
+    GenerationStats stats;
+    stats.run = runs_;
+    stats.island = &island - islands_.data();
+    stats.generation = island.generations;
+    stats.time = elapsed();
 
-            for (int j = 1; j <= point1; ++j)
-            {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
-            }
-            for (int j = point2; j <= point3; ++j)
+    std::vector<int> fitness(population_size_);
+    for (std::size_t i = 0; i < population_size_; ++i)
+        fitness[i] = island.population[i].getFitness();
+    std::nth_element(fitness.begin(), fitness.begin() + population_size_ / 2, fitness.end());
+    stats.median = fitness[population_size_ / 2];
+    stats.best = *std::min_element(fitness.begin(), fitness.end());
+    stats.worst = *std::max_element(fitness.begin(), fitness.end());
+
+    // Sum of the Hamming distances over all pairs: a gene set in k of the individuals differs in
+    // k (population_size_ - k) of them. The k of the 64 genes of a word are added up at once in a
+    // bit-sliced counter, plane p holding bit p of every k.
+    uint64_t distance = 0;
+    std::size_t num_planes = 1;
+    while ((std::size_t)1 << num_planes <= population_size_)
+        ++num_planes;
+    std::vector<uint64_t> planes(num_planes);
+    for (std::size_t w = 0; w < free_mask_.size(); ++w)
+    {
+        std::fill(planes.begin(), planes.end(), 0);
+        for (std::size_t i = 0; i < population_size_; ++i)
+        {
+            uint64_t carry = island.population[i].getWord(w);
+            for (std::size_t p = 0; carry; ++p)
             {
-                if (!formula_.fix[j])
-                {
-                    child1[j] = parent2[j];
-                    child2[j] = parent1[j];
-                }
+                uint64_t next = planes[p] & carry;
+                planes[p] ^= carry;
+                carry = next;
             }
         }
+        for (int b = 0; b < 64; ++b)
+        {
+            uint64_t k = 0;
+            for (std::size_t p = 0; p < num_planes; ++p)
+                k |= (planes[p] >> b & 1) << p;
+            distance += k * (population_size_ - k);
+        }
+    }
+    std::size_t pairs = population_size_ * (population_size_ - 1) / 2;
+    stats.diversity = pairs ? (double)distance / pairs : 0;
+
+    const EvaluationCounts &counts = island.last_evaluations;
+    stats.full = counts.full;
+    stats.delta = counts.delta;
+    stats.inherited = counts.inherited;
+    stats.cached = counts.cached;
+
+    const GenerationTimes &times = island.times;
+    stats.selection = times.selection;
+    stats.crossover = times.crossover;
+    stats.mutation = times.mutation;
+    stats.evaluation = times.evaluation;
+    stats.improvement = times.improvement;
+    telemetry_->write(stats);
+}
+
+// True when every island went stagnation_limit_ generations without improving its best fitness
+bool GeneticAlgorithm::stagnated() const
+{
+    if (stagnation_limit_ <= 0)
+        return false;
+    for (const Island &island : islands_)
+        if (island.stalled < stagnation_limit_ || island.population[0].getFitness() < island.best_fitness)
+            return false;
+    return true;
+}
+
+// Default number of generations: a fixed amount of clause evaluations per run, so that one generation
+// costs about nClauses x pop-size of them, kept within sensible bounds
+int GeneticAlgorithm::auto_generations() const
+{
+    const double clause_evaluations = 2e8;
+    double work = std::max<double>(1, (double)view_.numClauses() * population_size_);
+    return (int)std::max(10.0, std::min(1000.0, clause_evaluations / work));
+}
+
+// Send copies of the best individuals of every island to the next island of the ring (or to a
+// random other island), where they replace the worst individuals. Migrants already present on
+// the destination island or worse than all of its individuals are dropped.
+void GeneticAlgorithm::migrate()
+{
+    std::size_t nislands = islands_.size();
+    std::size_t nmigrants = std::min<std::size_t>(num_migrants_, population_size_ - 1);
+    if (nislands < 2 || nmigrants == 0)
+        return;
+
+    // Take all the migrants before any island receives some
+    migrants_.clear();
+    for (Island &island : islands_)
+    {
+        island.population.sort();
+        for (std::size_t i = 0; i < nmigrants; ++i)
+            migrants_.push_back(island.population[i]);
+    }
 
-        // Evaluate the fitness of the offspring
-        // child1.setFitness(fitness(child1));
-        // child2.setFitness(fitness(child2));
-
-        // // Perform mutation with a given probability
-        // if (child1.no_unsatisfying_variables())
-        // {
-        //     int mut_var = dist2(rng);
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child1.get_unsatisfying_variables();
-        //     assert(!child1.no_unsatisfying_variables());
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child1[unsat_var] = 1 - child1[unsat_var];
-        //             break;
-        //         }
-        //     }
-        //     // int mut_var = child1.getRandomUnsatisfyingVariable();
-        //     // // std::cout << "mut_var: " << mut_var << std::endl;
-        //     // assert(!formula_.fix[mut_var]);
-        //     // child1[mut_var] = 1 - child1[mut_var]; // flip the bit
-        // }
-
-        // if (child2.no_unsatisfying_variables())
-        // {
-        //     if (dist(rng) < mutation_rate_)
-        //     {
-        //         int mut_var = dist2(rng);
-        //         if (!formula_.fix[mut_var])
-        //         {
-        //             child2[mut_var] = 1 - child2[mut_var]; // flip the bit
-        //         }
-        //     }
-        // }
-        // else
-        // {
-
-        //     assert(!child2.no_unsatisfying_variables());
-
-        //     std::vector<std::pair<int, int>> unsat_vars = child2.get_unsatisfying_variables();
-        //     for (auto &var : unsat_vars)
-        //     {
-        //         int unsat_var = var.first;
-        //         assert(!formula_.fix[unsat_var]);
-        //         if (dist(rng) < mutation_rate_)
-        //         {
-        //             child2[unsat_var] = 1 - child2[unsat_var];
-        //         }
-        //     }
-        // }
-        std::vector<unsigned> &centrality_vars = formula_.get_degree_centrality_variables();
-        for (auto &var : centrality_vars)
+    std::uniform_int_distribution<std::size_t> dist(0, nislands - 2);
+    for (std::size_t k = 0; k < nislands; ++k)
+    {
+        std::size_t dest = (k + 1) % nislands;
+        if (random_topology_)
         {
-            // int unsat_var = var.first;
-            // assert(!formula_.fix[var]);
-            if (dist(rng) < mutation_rate_ && !formula_.fix[var])
-            {
-                child1[var] = 1 - child1[var];
-                child2[var] = 1 - child1[var];
-            }
+            dest = dist(migration_rng_);
+            dest += dest >= k;
         }
+        accept_migrants(islands_[dest].population, &migrants_[k * nmigrants], nmigrants);
+    }
+}
 
-        // Add the offspring to the vector
-        offspring.push_back(std::move(child1));
-        offspring.push_back(std::move(child2));
+// Replace the worst individuals of a sorted population by the migrants (best first) and sort it again.
+// Migrants already present or worse than the individual they would replace are dropped.
+void GeneticAlgorithm::accept_migrants(Population &population, Solution *migrants, std::size_t count)
+{
+    std::size_t slot = population_size_;
+    for (std::size_t i = 0; i < count && slot > 1; ++i)
+    {
+        Solution &migrant = migrants[i];
+        bool present = false;
+        for (std::size_t j = 0; j < population_size_ && !present; ++j)
+            present = population[j].getHash() == migrant.getHash();
+        if (present || population[slot - 1].getFitness() < migrant.getFitness())
+            continue;
+        std::swap(population[--slot], migrant);
     }
+    population.sort();
+}
+
+//=================================================================================================
+// Exchange between processes: segment 0 of every rank holds an outbox and an inbox of nsent_
+// individuals, followed by one result slot per rank (used on rank 0 by gather()).
+
+enum
+{
+    NOTIFY_MIGRANTS = 0,     // Inbox filled, the value is the number of migrants.
+    NOTIFY_MIGRANTS_ACK = 1, // Inbox of the next rank consumed, the outbox may be sent again.
+    NOTIFY_BEST = 2          // NOTIFY_BEST + r: best fitness of rank r plus one.
+};
+
+static const Gaspi::segment_id_t exchange_segment = 0;
 
-    return offspring;
+void GeneticAlgorithm::create_exchange()
+{
+    Gaspi::rank_t nranks = gaspi_->size();
+    entry_size_ = sizeof(int64_t) + Solution::num_words(solution_size_) * sizeof(uint64_t);
+    nsent_ = std::max<std::size_t>(1, std::min<std::size_t>(num_migrants_, population_size_ - 1));
+    gaspi_->segment_create(exchange_segment, (2 * nsent_ + nranks) * entry_size_);
+    mailbox_free_ = true;
+    published_best_ = -1;
 }
 
-// Select the best solutions to survive to the next generation
-void GeneticAlgorithm::select_survivors(const std::vector<Solution> &offspring)
-{
-    // Combine the population and offspring
-    std::vector<Solution> combined(population_.getPopulation());
-    // combined.resize(combined.size() + offspring.size());
-    combined.insert(combined.end(), offspring.begin(), offspring.end());
-    // std::cout << "combined size before: " << combined.size() << std::endl;
-    // Select the best solutions to survive
-    size_t erasureCount = 0;
-    size_t maxErasures = combined.size() - population_size_;
-    if (maxErasures > 0)                                                                                                               // Maximum allowed erasures
-        combined.erase(unique(combined.begin(), combined.end(), [&erasureCount, maxErasures](const Solution &s1, const Solution &s2) { // Lambda function to compare solutions
-                           if (erasureCount < maxErasures)
-                           {
-                               ++erasureCount;
-                               return s1 == s2;
-                           }
-                           else
-                           {
-                               return false;
-                           }
-                       }),
-                       combined.end());
-
-    // Sort the combined vector by fitness in ascending order
-    std::sort(combined.begin(), combined.end(),
-              [](const Solution &s1, const Solution &s2)
-              { return s1.getFitness() < s2.getFitness(); });
-
-    population_.setPopulation(std::vector<Solution>(combined.begin(), combined.begin() + population_size_));
-    assert(population_.getPopulation().size() == population_size_);
-    combined.clear();
-    combined.shrink_to_fit();
+// Copy an individual to / from the local slice of the exchange segment
+void GeneticAlgorithm::pack(const Solution &solution, std::size_t offset)
+{
+    char *entry = (char *)gaspi_->segment_ptr(exchange_segment) + offset;
+    int64_t fitness = solution.getFitness();
+    memcpy(entry, &fitness, sizeof(fitness));
+    memcpy(entry + sizeof(fitness), solution.data(), solution.numWords() * sizeof(uint64_t));
 }
 
-// Select the best solutions to survive to the next generation
-void GeneticAlgorithm::select_survivors_ellitist(const std::vector<Solution> &offspring)
-{
-    // Combine the population and offspring
-    std::vector<Solution> combined(population_.getPopulation());
-    // combined.resize(combined.size() + offspring.size());
-    combined.insert(combined.end(), offspring.begin(), offspring.end());
-    // std::cout << "combined size before: " << combined.size() << std::endl;
-    // Select the best solutions to survive
-    size_t erasureCount = 0;
-    size_t maxErasures = combined.size() - population_size_;
-    if (maxErasures > 0)                                                                                                               // Maximum allowed erasures
-        combined.erase(unique(combined.begin(), combined.end(), [&erasureCount, maxErasures](const Solution &s1, const Solution &s2) { // Lambda function to compare solutions
-                           if (erasureCount < maxErasures)
-                           {
-                               ++erasureCount;
-                               return s1 == s2;
-                           }
-                           else
-                           {
-                               return false;
-                           }
-                       }),
-                       combined.end());
-
-    // Sort the combined vector by fitness in ascending order
-    std::sort(combined.begin(), combined.end(),
-              [](const Solution &s1, const Solution &s2)
-              { return s1.getFitness() < s2.getFitness(); });
+void GeneticAlgorithm::unpack(Solution &solution, std::size_t offset)
+{
+    const char *entry = (const char *)gaspi_->segment_ptr(exchange_segment) + offset;
+    int64_t fitness;
+    memcpy(&fitness, entry, sizeof(fitness));
+    for (std::size_t w = 0; w < solution.numWords(); ++w)
+    {
+        uint64_t word;
+        memcpy(&word, entry + sizeof(fitness) + w * sizeof(uint64_t), sizeof(word));
+        solution.setWord(w, word);
+    }
+    solution.setFitness(fitness);
+    if (incremental_)
+        evaluator_.init(solution);
+    else if (weight_interval_ > 0)
+        solution.setFitness(this->fitness(solution)); // Scored with the weights of the sender
+}
 
-    // Select the 50% best and 50% worst solutions to survive
-    size_t nbest = population_size_ / 2;
-    size_t nworst = population_size_ - nbest;
+// Called by every rank after each epoch: send the best individuals to the next rank once it consumed
+// the previous ones, take in the migrants of the previous rank, and publish / learn best fitnesses.
+void GeneticAlgorithm::exchange()
+{
+    Gaspi::rank_t me = gaspi_->rank();
+    Gaspi::rank_t nranks = gaspi_->size();
+    if (nranks < 2)
+        return;
+
+    for (Island &island : islands_)
+        island.population.sort();
+    Island *best = &islands_[0];
+    Island *worst = &islands_[0];
+    for (Island &island : islands_)
+    {
+        if (island.population[0].getFitness() < best->population[0].getFitness())
+            best = &island;
+        if (island.population[0].getFitness() > worst->population[0].getFitness())
+            worst = &island;
+    }
 
-    std::vector<Solution> survivors;
-    survivors.reserve(population_size_);
-    survivors.insert(survivors.end(), combined.begin(), combined.begin() + nbest);
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(combined.begin() + nbest, combined.end(), g);
-    survivors.insert(survivors.end(), combined.begin() + nbest, combined.begin() + nbest + nworst);
-    // survivors.insert(survivors.end(), combined.end() - nworst, combined.end());
-    population_.setPopulation(survivors);
-    assert(population_.getPopulation().size() == population_size_);
-    combined.clear();
-    combined.shrink_to_fit();
-    survivors.clear();
-    survivors.shrink_to_fit();
-}
-
-// void GeneticAlgorithm::select_survivors(const std::vector<Solution> &offspring)
-// {
-//     // Sort the population and offspring by fitness
-//     std::vector<Solution> combined;
-//     combined.reserve(population_size_ + offspring.size());
-//     combined.insert(combined.end(), population_.population.begin(), population_.population.end());
-//     combined.insert(combined.end(), offspring.begin(), offspring.end());
-//     std::sort(combined.begin(), combined.end(), [](const Solution &s1, const Solution &s2)
-//               { return s1.fitness < s2.fitness; });
-
-//     // Select the best solutions to survive
-//     population_.population.clear();
-//     for (int i = 0; i < population_size_; ++i)
-//     {
-
-//         population_.population.push_back(std::move(combined[i]));
-//     }
-// }
+    if (gaspi_->notify_reset(exchange_segment, NOTIFY_MIGRANTS_ACK))
+        mailbox_free_ = true;
+    if (mailbox_free_)
+    {
+        for (std::size_t i = 0; i < nsent_; ++i)
+            pack(best->population[i], i * entry_size_);
+        gaspi_->write_notify(exchange_segment, 0, (me + 1) % nranks, exchange_segment, nsent_ * entry_size_,
+                             nsent_ * entry_size_, NOTIFY_MIGRANTS, nsent_);
+        mailbox_free_ = false;
+    }
 
-// Check if a satisfactory solution has been found
-bool GeneticAlgorithm::solution_found()
+    if (Gaspi::notification_t count = gaspi_->notify_reset(exchange_segment, NOTIFY_MIGRANTS))
+    {
+        migrants_.assign(count, worst->population[0]);
+        for (std::size_t i = 0; i < count; ++i)
+            unpack(migrants_[i], (nsent_ + i) * entry_size_);
+        gaspi_->notify(exchange_segment, (me + nranks - 1) % nranks, NOTIFY_MIGRANTS_ACK, 1);
+        std::sort(migrants_.begin(), migrants_.end(), [](const Solution &a, const Solution &b)
+                  { return a.getFitness() < b.getFitness(); });
+        accept_migrants(worst->population, migrants_.data(), migrants_.size());
+    }
+
+    int fitness = objective(getBestSolution());
+    if (published_best_ < 0 || fitness < published_best_)
+    {
+        published_best_ = fitness;
+        for (Gaspi::rank_t r = 0; r < nranks; ++r)
+            if (r != me)
+                gaspi_->notify(exchange_segment, r, NOTIFY_BEST + me, fitness + 1);
+    }
+    for (Gaspi::rank_t r = 0; r < nranks; ++r)
+    {
+        // A model found by another rank ends the search everywhere
+        if (r != me && gaspi_->notify_reset(exchange_segment, NOTIFY_BEST + r) == 1)
+            stop(STOP_SOLVED);
+    }
+    gaspi_->wait();
+}
+
+// Collect the best solution of every rank on rank 0, which returns the best of all of them. The
+// other ranks return their own best solution.
+Solution GeneticAlgorithm::gather()
 {
-    // Check if the fittest solution satisfies all the clauses
-    Solution &fittest = population_[0];
-    return fittest.getFitness() == 0;
+    Gaspi::rank_t me = gaspi_->rank();
+    Gaspi::rank_t nranks = gaspi_->size();
+    Solution best = getBestSolution();
+    std::size_t results = 2 * nsent_ * entry_size_;
+    Gaspi::notification_id_t first = NOTIFY_BEST + nranks;
+
+    if (me != 0)
+    {
+        pack(best, results + me * entry_size_);
+        gaspi_->write_notify(exchange_segment, results + me * entry_size_, 0, exchange_segment,
+                             results + me * entry_size_, entry_size_, first + me, 1);
+        gaspi_->wait();
+        return best;
+    }
+
+    Solution solution(best);
+    for (Gaspi::rank_t n = 1; n < nranks; ++n)
+    {
+        Gaspi::notification_id_t id;
+        gaspi_->notify_waitsome(exchange_segment, first + 1, nranks - 1, id, Gaspi::block);
+        gaspi_->notify_reset(exchange_segment, id);
+        unpack(solution, results + (id - first) * entry_size_);
+        if (objective(solution) < objective(best))
+            best = solution;
+    }
+    return best;
 }
 
-// Get the fittest solution
+// Get the fittest solution over all islands. With clause weighting, the population order follows the
+// weighted fitness, so every individual is compared by raw fitness.
 Solution &GeneticAlgorithm::getBestSolution()
 {
-    return population_[0];
+    if (weight_interval_ > 0)
+    {
+        Solution *best = &islands_[0].population[0];
+        int best_fitness = rawFitness(*best);
+        for (Island &island : islands_)
+        {
+            for (std::size_t i = 0; i < population_size_; ++i)
+            {
+                int fitness = rawFitness(island.population[i]);
+                if (fitness < best_fitness)
+                {
+                    best = &island.population[i];
+                    best_fitness = fitness;
+                }
+            }
+        }
+        return *best;
+    }
+    Island *best = &islands_[0];
+    for (Island &island : islands_)
+        if (island.population[0].getFitness() < best->population[0].getFitness())
+            best = &island;
+    return best->population[0];
 }
 
-// Get the worst solution
+// Get the worst solution over all islands
 Solution &GeneticAlgorithm::getWorstSolution()
 {
-    return population_[population_size_ - 1];
+    Island *worst = &islands_[0];
+    for (Island &island : islands_)
+        if (island.population[population_size_ - 1].getFitness() > worst->population[population_size_ - 1].getFitness())
+            worst = &island;
+    return worst->population[population_size_ - 1];
 }
 
-void SAGA::initialize_polarity(Solution &solution, Minisat::Solver &solver)
+// Variables without a gene keep their polarity, they are assigned or eliminated anyway
+void SAGA::initialize_polarity(Solution &solution, const GeneMap &genes, Minisat::Solver &solver)
 {
-    int num_vars = solver.nVars();
-    for (int i = 0; i < num_vars; ++i)
+    for (std::size_t g = 1; g < genes.size(); ++g)
     {
-        solver.setPolarity(i, solution[i + 1] ? true : false);
+        solver.setPolarity(genes.var(g), solution[g] ? true : false);
     }
-}
\ No newline at end of file
+}
+
+Solution Rephaser::from_phases(const Minisat::vec<char> &phases) const
+{
+    const GeneMap &genes = ga.getGeneMap();
+    Solution solution(genes.size(), 0);
+    for (std::size_t g = 1; g < genes.size(); ++g)
+        solution[g] = phases[genes.var(g)];
+    return solution;
+}
+
+// The conflict rate is measured between two rephasings, so the time of the GA runs is left out
+bool Rephaser::rephase(Minisat::vec<char> &polarity, const Minisat::vec<char> &best, uint64_t restarts, uint64_t conflicts)
+{
+    if (restarts < next)
+        return false;
+
+    double rate = (conflicts - window_conflicts) / std::max(Minisat::cpuTime() - window_start, 1e-3);
+    if (last_rate >= 0 && rate >= last_rate)
+    {
+        interval = std::max(interval * 3 / 4, 1);
+        generations = std::min(generations * 2, 1000);
+    }
+    else if (last_rate >= 0)
+    {
+        interval = std::min(interval * 2, 100000);
+        generations = std::max(generations / 2, min_generations);
+    }
+    last_rate = rate;
+
+    std::vector<Solution> seeds;
+    seeds.push_back(from_phases(polarity));
+    seeds.push_back(from_phases(best));
+    Solution refined(ga.refine(seeds, generations));
+    raw_fitness = ga.rawFitness(refined);
+    const GeneMap &genes = ga.getGeneMap();
+    for (std::size_t g = 1; g < genes.size(); ++g)
+        polarity[genes.var(g)] = refined[g];
+
+    rephases++;
+    next = restarts + interval;
+    window_start = Minisat::cpuTime();
+    window_conflicts = conflicts;
+    return true;
+}
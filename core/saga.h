@@ -13,11 +13,18 @@
 #include <math.h>
 #include <utility>
 #include <random>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include "utils/System.h"
 #include "core/SolverTypes.h"
 #include "core/Solver.h"
 // #include "simp/Symmetry.h"
 
-#include <boost/compute/detail/lru_cache.hpp>
+#include "core/Random.h"
+#include "core/ThreadPool.h"
+#include "core/Gaspi.h"
+#include "core/Telemetry.h"
 
 namespace SAGA
 {
@@ -36,14 +43,12 @@ namespace SAGA
         Formula() = default;
         Formula(int numVariables, int numClauses)
             : numVariables(numVariables), numClauses(numClauses),
-              fix(numVariables + 1, 0),
-              fixed_vars(numVariables + 1, 0)
+              fix(numVariables + 1, 0)
         {
         }
 
         Formula(const Formula &other) : numVariables(other.numVariables), numClauses(other.numClauses),
                                         fix(other.fix),
-                                        fixed_vars(other.fixed_vars),
 
                                         degree_centrality_variables(other.degree_centrality_variables)
         {
@@ -56,7 +61,6 @@ namespace SAGA
             numVariables = other.numVariables;
             numClauses = other.numClauses;
             fix = other.fix;
-            fixed_vars = other.fixed_vars;
             degree_centrality_variables = other.degree_centrality_variables;
             return *this;
         }
@@ -76,17 +80,11 @@ namespace SAGA
             return fix;
         }
 
-        std::vector<bool> &getFixedVars()
-        {
-            return fixed_vars;
-        }
-
         void setNumVariables(int numVariables)
         {
             this->numVariables = numVariables;
             // this->var_lit_count.resize(numVariables + 1);
             this->fix.resize(numVariables + 1);
-            this->fixed_vars.resize(numVariables + 1);
         }
 
         void setNumClauses(int numClauses)
@@ -119,8 +117,7 @@ namespace SAGA
             binary_clauses.emplace_back(lit1, lit2);
         }
 
-        std::vector<bool> fix;        // fixed variable.
-        std::vector<bool> fixed_vars; // Values of  Fixed variables.
+        std::vector<bool> fix; // Variables of unit clauses, left out of the chromosome.
 
     private:
         std::vector<unsigned> degree_centrality_variables;
@@ -129,22 +126,77 @@ namespace SAGA
         int numClauses;
     };
 
+    // 128-bit Zobrist-style hash of a chromosome: the XOR over all words of a pseudo-random
+    // function of (word index, word value). Zero words contribute nothing, and changing one word
+    // only needs the contributions of its old and new value.
+    struct ChromosomeHash
+    {
+        uint64_t lo = 0;
+        uint64_t hi = 0;
+
+        bool operator==(const ChromosomeHash &h) const { return lo == h.lo && hi == h.hi; }
+        bool operator!=(const ChromosomeHash &h) const { return !(*this == h); }
+
+        static uint64_t mix(uint64_t x)
+        {
+            x ^= x >> 30;
+            x *= 0xBF58476D1CE4E5B9ULL;
+            x ^= x >> 27;
+            x *= 0x94D049BB133111EBULL;
+            return x ^ (x >> 31);
+        }
+
+        // Toggle the contribution of value x stored in word w
+        void toggle(std::size_t w, uint64_t x)
+        {
+            if (!x)
+                return;
+            lo ^= mix(x ^ mix(w * 0x9E3779B97F4A7C15ULL + 1));
+            hi ^= mix(x + mix(w * 0xD1B54A32D192ED03ULL + 2) * 0x2545F4914F6CDD1DULL);
+        }
+    };
+
     class Solution
     {
     public:
-        Solution(const Solution &other) : solution(other.solution), fitness(other.fitness) //, unsatisfying_variables(other.unsatisfying_variables)
+        // Genes are stored bit-packed, 64 variables per word. The non-const operator[]
+        // hands out this proxy so that callers can keep reading and writing genes as 0/1.
+        class reference
+        {
+        public:
+            reference(Solution &solution, std::size_t i) : solution_(solution), i_(i) {}
+            operator unsigned() const { return solution_.get(i_); }
+            reference &operator=(unsigned value)
+            {
+                solution_.set(i_, value);
+                return *this;
+            }
+            reference &operator=(const reference &other) { return *this = (unsigned)other; }
+
+        private:
+            Solution &solution_;
+            std::size_t i_;
+        };
+
+        Solution(const Solution &other) : words(other.words), nbits(other.nbits), fitness(other.fitness), hash(other.hash),
+                                          true_counts(other.true_counts), changes(other.changes)
+        {
+        }
+        Solution(Solution &&other) noexcept : words(std::move(other.words)), nbits(other.nbits), fitness(other.fitness),
+                                              hash(other.hash), true_counts(std::move(other.true_counts)),
+                                              changes(std::move(other.changes))
         {
         }
-        Solution(std::vector<unsigned> solution_, int fitness_) : solution(solution_), fitness(fitness_) //, unsatisfying_variables()
+        Solution(std::vector<unsigned> solution_, int fitness_) : words(), nbits(0), fitness(fitness_)
         {
+            setSolution(solution_);
         }
         Solution(size_t solution_size, int nclauses)
-            : solution(solution_size), fitness(nclauses) //, unsatisfying_variables()
+            : words(num_words(solution_size), 0), nbits(solution_size), fitness(nclauses)
         {
-            solution.reserve(solution_size);
         }
 
-        Solution() : solution(), fitness(1000000) {}
+        Solution() : words(), nbits(0), fitness(1000000) {}
 
         ~Solution() {}
 
@@ -153,17 +205,31 @@ namespace SAGA
         {
             if (this != &other)
             {
-                solution = other.solution;
+                words = other.words;
+                nbits = other.nbits;
                 fitness = other.fitness;
-                // unsatisfying_variables = other.unsatisfying_variables;
+                hash = other.hash;
+                true_counts = other.true_counts;
+                changes = other.changes;
             }
 
             return *this;
         }
 
+        Solution &operator=(Solution &&other) noexcept
+        {
+            words = std::move(other.words);
+            nbits = other.nbits;
+            fitness = other.fitness;
+            hash = other.hash;
+            true_counts = std::move(other.true_counts);
+            changes = std::move(other.changes);
+            return *this;
+        }
+
         bool operator==(const Solution &s) const
         {
-            return solution == s.solution && fitness == s.fitness;
+            return hash == s.hash && nbits == s.nbits && fitness == s.fitness && words == s.words;
         }
 
         bool operator!=(const Solution &s) const
@@ -171,73 +237,115 @@ namespace SAGA
             return !(*this == s);
         }
 
-        const unsigned &operator[](std::size_t i) const { return solution[i]; }
-        unsigned &operator[](std::size_t i)
+        unsigned operator[](std::size_t i) const { return get(i); }
+        reference operator[](std::size_t i)
+        {
+            return reference(*this, i);
+        }
+
+        unsigned get(std::size_t i) const { return (words[word_index(i)] >> (i & 63)) & 1; }
+        void set(std::size_t i, unsigned value)
         {
-            return solution[i];
+            uint64_t w = words[word_index(i)];
+            setWord(word_index(i), value ? w | bit_mask(i) : w & ~bit_mask(i));
+        }
+        void flip(std::size_t i) { setWord(word_index(i), words[word_index(i)] ^ bit_mask(i)); }
+
+        // All writes to the chromosome go through setWord() so that the hash and the change log stay up to date
+        uint64_t getWord(std::size_t w) const { return words[w]; }
+        void setWord(std::size_t w, uint64_t value)
+        {
+            uint64_t bits = words[w] ^ value;
+            if (!bits)
+                return;
+            hash.toggle(w, words[w]);
+            hash.toggle(w, value);
+            words[w] = value;
+            if (!changes.empty() && changes.back().first == w)
+                changes.back().second ^= bits;
+            else
+                changes.push_back(std::make_pair((uint32_t)w, bits));
         }
 
         std::string toString() const
         {
             std::ostringstream oss;
-            for (int i = 1; i < size(); ++i)
-                oss << (solution[i] ? "" : "-") << i << " ";
+            for (std::size_t i = 1; i < size(); ++i)
+                oss << (get(i) ? "" : "-") << i << " ";
             oss << std::endl;
             return oss.str();
         }
 
         // Getters and setters
         int getFitness() const { return fitness; }
-        void setFitness(int fitness_) { fitness = fitness_; }
-        std::size_t size() const { return solution.size(); }
-        void resize(std::size_t size_) { solution.resize(size_); }
-        std::vector<unsigned> getSolution() const { return solution; }
-        void setSolution(std::vector<unsigned> solution_) { solution = solution_; }
-        // std::vector<unsigned> get_unsatisfying_variables() const { return unsatisfying_variables; }
-
-        // bool no_unsatisfying_variables() const
-        // {
-        //     return unsatisfying_variables.empty();
-        // }
-
-        // void add_unsatisfying_variable(int var)
-        // {
-        //     // Check if the variable already exists in the vector
-        //     if (std::find(unsatisfying_variables.begin(), unsatisfying_variables.end(), var) == unsatisfying_variables.end())
-        //     {
-        //         unsatisfying_variables.push_back(var);
-        //     }
-        // }
-
-        // int getRandomUnsatisfyingVariable()
-        // {
-        //     std::random_device rd;
-        //     std::mt19937 rng(rd());
-        //     // std::cout << "unsat var size: " << unsatisfying_variables.size() << std::endl;
-        //     std::uniform_int_distribution<int> dis(0, unsatisfying_variables.size() - 1);
-        //     return unsatisfying_variables[dis(rng)].first;
-        // }
-
-        // int getMaxUnsatisfyingVariable()
-        // {
-
-        //     int max = 0;
-        //     int max_var = 0;
-        //     for (auto var : unsatisfying_variables)
-        //     {
-        //         if (var.second > max)
-        //         {
-        //             max = var.second;
-        //             max_var = var.first;
-        //         }
-        //     }
-        //     return max_var;
-        // }
+        void setFitness(int fitness_)
+        {
+            fitness = fitness_;
+            changes.clear();
+        }
+        const ChromosomeHash &getHash() const { return hash; }
+        std::size_t size() const { return nbits; }
+        void resize(std::size_t size_)
+        {
+            words.resize(num_words(size_), 0);
+            nbits = size_;
+            // Keep the padding bits of the last word cleared, equality relies on it.
+            if (nbits & 63)
+                words.back() &= ~0ULL >> (64 - (nbits & 63));
+            rehash();
+        }
+        std::vector<unsigned> getSolution() const
+        {
+            std::vector<unsigned> solution(nbits);
+            for (std::size_t i = 0; i < nbits; ++i)
+                solution[i] = get(i);
+            return solution;
+        }
+        void setSolution(const std::vector<unsigned> &solution_)
+        {
+            words.assign(num_words(solution_.size()), 0);
+            nbits = solution_.size();
+            for (std::size_t i = 0; i < nbits; ++i)
+                if (solution_[i])
+                    words[word_index(i)] |= bit_mask(i);
+            rehash();
+        }
+
+        // Read-only access to the packed chromosome, used by the word-wise genetic operators.
+        const std::vector<uint64_t> &getWords() const { return words; }
+        std::size_t numWords() const { return words.size(); }
+        const uint64_t *data() const { return words.data(); }
+
+        // Per-clause true literal counters maintained by the IncrementalEvaluator (empty if unused).
+        std::vector<uint32_t> &getTrueCounts() { return true_counts; }
+        const std::vector<uint32_t> &getTrueCounts() const { return true_counts; }
+        bool hasTrueCounts() const { return !true_counts.empty(); }
+
+        // Words written since the fitness was last set, with the bits that changed. A word may occur more
+        // than once, the net change of a word being the xor of its entries. No entry means that the
+        // fitness (and the counters) still describe the chromosome, e.g. in a child copied from its parent.
+        typedef std::pair<uint32_t, uint64_t> Change;
+        const std::vector<Change> &getChanges() const { return changes; }
+        bool changed() const { return !changes.empty(); }
+
+        static std::size_t num_words(std::size_t nbits_) { return (nbits_ + 63) >> 6; }
+        static std::size_t word_index(std::size_t i) { return i >> 6; }
+        static uint64_t bit_mask(std::size_t i) { return 1ULL << (i & 63); }
 
     private:
-        std::vector<unsigned> solution;
-        // std::vector<unsigned> unsatisfying_variables; // Vector that maps unsatisfying variables to the number of clauses they do not satisfy
+        void rehash()
+        {
+            hash = ChromosomeHash();
+            for (std::size_t w = 0; w < words.size(); ++w)
+                hash.toggle(w, words[w]);
+        }
+
+        std::vector<uint64_t> words; // Chromosome, one bit per variable (bit 0 of word 0 is unused).
+        std::size_t nbits;           // Number of genes, i.e. number of variables + 1.
         int fitness;
+        ChromosomeHash hash;               // Kept up to date on every write to words.
+        std::vector<uint32_t> true_counts; // Number of true literals of each clause of the ClauseView.
+        std::vector<Change> changes;       // Change log, cleared by setFitness().
     };
 
     class Population
@@ -249,7 +357,7 @@ namespace SAGA
         }
         Population(const Population &other) : population(other.population), population_size(other.population_size) {}
         Population(int population_size_, int solution_size, int nclauses)
-            : population(population_size_), population_size(population_size_)
+            : population(), population_size(population_size_)
         {
             population.reserve(population_size_);
             for (int i = 0; i < population_size_; ++i)
@@ -287,13 +395,12 @@ namespace SAGA
         // Getters and setters
         std::size_t size() const { return population.size(); }
         void resize(std::size_t size_) { population.resize(size_); }
-        void setPopulation(std::vector<Solution> population_)
+        // Exchange the individuals of two populations without copying any chromosome
+        void swap(Population &other)
         {
-            population.clear();
-            population.shrink_to_fit();
-            population = population_;
+            population.swap(other.population);
+            std::swap(population_size, other.population_size);
         }
-        std::vector<Solution> getPopulation() const { return population; }
         void push_back(Solution solution) { population.push_back(std::move(solution)); }
 
         void sort()
@@ -316,70 +423,885 @@ namespace SAGA
         std::vector<Solution> population; // Population of solutions
     };
 
+    // Dense numbering of the variables evolved by the GA: the decision variables still unassigned
+    // after simplification. Variables eliminated by the SimpSolver, assigned at level 0 or fixed by a
+    // unit clause get no gene, so chromosomes only span what is left of the search space.
+    class GeneMap
+    {
+    public:
+        void build(Minisat::Solver &solver, const Formula &formula);
+
+        std::size_t size() const { return vars.size(); } // Number of genes, the unused gene 0 included.
+        Minisat::Var var(std::size_t g) const { return vars[g]; }
+        uint32_t gene(Minisat::Var v) const { return genes[v]; } // 0 if v has no gene.
+
+    private:
+        std::vector<Minisat::Var> vars; // Variable of each gene.
+        std::vector<uint32_t> genes;    // Gene of each variable.
+    };
+
+    // Hands the best chromosome of a GA running next to the CDCL search over to the solver, which
+    // adopts it as its preferred polarities at the next restart
+    class PhaseExchange : public Minisat::PhaseHook
+    {
+    public:
+        explicit PhaseExchange(const GeneMap &genes_)
+            : genes(genes_), phases(genes_.size(), 0), best(INT32_MAX), fresh(false), updates(0)
+        {
+        }
+
+        // GA side: keep the phases of 'solution' if its 'fitness' is better than the last one published
+        void publish(const Solution &solution, int fitness);
+        // Solver side: copy the phases published since the last call, never waits for the GA
+        bool fetch(Minisat::vec<char> &polarity);
+
+        int getBestFitness() const { return best; }
+        uint64_t getUpdates() const { return updates; } // Phase vectors taken by the solver.
+
+    private:
+        const GeneMap &genes;
+        std::mutex mutex;
+        std::vector<char> phases; // Genes of the best solution published.
+        std::atomic<int> best;
+        std::atomic<bool> fresh; // phases were not fetched yet.
+        uint64_t updates;
+    };
+
+    // Flat, read-only snapshot of the problem clauses used to score individuals. Literals are
+    // stored contiguously as (gene << 1 | sign) and clauses are delimited by an offset array.
+    // Clauses satisfied by a fixed variable are dropped and fixed-false literals are stripped, so
+    // the view does not depend on the solver's clause arena once it has been built. Learnt clauses
+    // may follow the original ones. Every clause has a weight, the number of unsatisfied clauses it
+    // counts for in the fitness: 1 for the original ones and 'learnt weight' for the learnt ones,
+    // until clause weighting changes them.
+    class ClauseView
+    {
+    public:
+        ClauseView() : offsets(1, 0), num_empty(0), num_original(0), learnt_weight(1), total_weight(0) {}
+
+        void build(Minisat::Solver &solver, const GeneMap &genes);
+        // Add the clauses of 'learnts' that still carry 'mark' (CORE, TIER2): a tier list may also hold
+        // clauses since promoted or demoted to another one
+        void add_learnts(Minisat::Solver &solver, const GeneMap &genes, Minisat::vec<Minisat::CRef> &learnts, unsigned mark, int weight);
+        void clear_learnts();
+
+        std::size_t numClauses() const { return offsets.size() - 1; }
+        std::size_t numOriginal() const { return num_original; }
+        std::size_t numLiterals() const { return literals.size(); }
+        int numEmpty() const { return num_empty; } // Clauses whose literals are all fixed to false.
+        int weight(std::size_t c) const { return weights[c]; }
+        int baseWeight(std::size_t c) const { return c < num_original ? 1 : learnt_weight; }
+        int64_t totalWeight() const { return total_weight; }
+        void addWeight(std::size_t c, int delta)
+        {
+            weights[c] += delta;
+            total_weight += delta;
+        }
+
+        const uint32_t *begin(std::size_t c) const { return literals.data() + offsets[c]; }
+        const uint32_t *end(std::size_t c) const { return literals.data() + offsets[c + 1]; }
+
+        static uint32_t gene(uint32_t lit) { return lit >> 1; }
+        static uint32_t sign(uint32_t lit) { return lit & 1; }
+        // A literal is satisfied when the gene of its variable equals its sign (cf. initialize_polarity).
+        static bool satisfied(uint32_t lit, const uint64_t *genes)
+        {
+            return ((genes[gene(lit) >> 6] >> (gene(lit) & 63)) & 1) == sign(lit);
+        }
+        bool clauseSatisfied(std::size_t c, const uint64_t *genes) const
+        {
+            for (const uint32_t *lit = begin(c); lit != end(c); ++lit)
+                if (satisfied(*lit, genes))
+                    return true;
+            return false;
+        }
+
+    private:
+        // Learnt clauses are only added while they carry 'mark'
+        void add(Minisat::Solver &solver, const GeneMap &genes, Minisat::vec<Minisat::CRef> &clauses, bool original, unsigned mark = 0);
+
+        std::vector<uint32_t> literals;
+        std::vector<uint32_t> offsets;
+        int num_empty;
+        std::size_t num_original; // Clauses [0, num_original) are original, the others learnt.
+        int learnt_weight;
+        std::vector<int> weights;
+        int64_t total_weight;
+    };
+
+    // Incremental fitness evaluation in the style of WalkSAT make/break bookkeeping. Each individual
+    // keeps the number of true literals of every clause of the view, so flipping a gene only visits
+    // the clauses its variable occurs in and a child is derived from its parent's counters plus the
+    // genes that crossover and mutation actually changed.
+    class IncrementalEvaluator
+    {
+    public:
+        IncrementalEvaluator() : view(nullptr) {}
+
+        void build(const ClauseView &view_, std::size_t num_genes);
+        bool ready() const { return view != nullptr; }
+
+        void init(Solution &solution) const; // Compute the counters from scratch.
+
+        // Delta evaluation of the genes logged by the solution since its fitness was set: apply_changes()
+        // updates the counters and the fitness, delta() returns the new fitness of a solution without
+        // counters by visiting the clauses of the changed genes before and after the changes.
+        void apply_changes(Solution &solution) const;
+        int delta(const Solution &solution) const;
+        std::size_t changed_occurrences(const Solution &solution) const; // Clauses visited by a delta evaluation.
+
+        // Clauses of the view containing literal 'lit'
+        const uint32_t *occ_begin(uint32_t lit) const { return occurrences.data() + occ_offsets[lit]; }
+        const uint32_t *occ_end(uint32_t lit) const { return occurrences.data() + occ_offsets[lit + 1]; }
+
+    private:
+        int update(Solution &solution, std::size_t w, uint64_t bits, int unsat) const;
+        const std::vector<uint64_t> &net_changes(const Solution &solution) const;
+
+        const ClauseView *view;
+        std::vector<uint32_t> occ_offsets; // Indexed by literal (gene << 1 | sign).
+        std::vector<uint32_t> occurrences; // Clause indices, grouped by literal.
+    };
+
+    // Bounded ProbSAT local search over the clause view, the memetic improvement step of SAGA. Break
+    // values are read from the true literal counters through the evaluator's occurrence index, and the
+    // best assignment met during the walk is the one written back.
+    class LocalSearch
+    {
+    public:
+        LocalSearch() : view(nullptr), evaluator(nullptr) {}
+
+        void build(const ClauseView &view_, const IncrementalEvaluator &evaluator_);
+        bool ready() const { return view != nullptr; }
+
+        // Run up to 'steps' flips on solution, then set its fitness (and counters, if it has some)
+        void improve(Solution &solution, int steps, Xoshiro256 &rng) const;
+
+    private:
+        const ClauseView *view;
+        const IncrementalEvaluator *evaluator;
+        std::vector<double> break_weights; // (eps + break)^-cb, indexed by the break value.
+    };
+
+    // Repair operator: the genes of an individual are assigned in a fixed order, each keeping its value
+    // unless unit propagation over the clause view forced the other one, which then overwrites it. A
+    // clause falsified by the propagation is left as it is, so a repair never backtracks. With a random
+    // order on a random chromosome, this is a CDCL dive without learning (dive()).
+    class UnitRepair
+    {
+    public:
+        UnitRepair() : view(nullptr), evaluator(nullptr) {}
+
+        // Assign the genes of 'order' first (e.g. the most central ones), then the others
+        void build(const ClauseView &view_, const IncrementalEvaluator &evaluator_, const std::vector<unsigned> &order_,
+                   std::size_t num_genes);
+        bool ready() const { return view != nullptr; }
+
+        void repair(Solution &solution) const;
+        void dive(Solution &solution, Xoshiro256 &rng) const;
+
+    private:
+        void propagate(Solution &solution, const std::vector<uint32_t> &decisions) const;
+
+        const ClauseView *view;
+        const IncrementalEvaluator *evaluator;
+        std::vector<uint32_t> order; // Every gene but 0, in decision order.
+    };
+
+    // Fixed-size, open-addressing cache of fitness values keyed by the chromosome hash. Entries
+    // live in aligned groups of four slots probed linearly; a full group overwrites one of its
+    // slots. Lookups and inserts never allocate and lock only the stripe owning the group.
+    class FitnessCache
+    {
+    public:
+        explicit FitnessCache(std::size_t capacity) : hits_(0), misses_(0) { resize(capacity); }
+
+        // Round the capacity up to a power of two (at least one group), 0 disables the cache
+        void resize(std::size_t capacity)
+        {
+            std::size_t size = 0;
+            if (capacity > 0)
+                for (size = group_size; size < capacity; size <<= 1)
+                    ;
+            entries_.assign(size, Entry());
+        }
+
+        bool lookup(const ChromosomeHash &key, int &value)
+        {
+            if (entries_.empty())
+                return false;
+            std::size_t group = group_of(key);
+            std::lock_guard<std::mutex> lock(locks_[stripe_of(group)]);
+            for (std::size_t i = group; i < group + group_size; ++i)
+            {
+                if (entries_[i].value >= 0 && entries_[i].key == key)
+                {
+                    value = entries_[i].value;
+                    hits_++;
+                    return true;
+                }
+            }
+            misses_++;
+            return false;
+        }
+
+        void insert(const ChromosomeHash &key, int value)
+        {
+            if (entries_.empty())
+                return;
+            std::size_t group = group_of(key);
+            std::lock_guard<std::mutex> lock(locks_[stripe_of(group)]);
+            std::size_t slot = group + (key.hi & (group_size - 1));
+            for (std::size_t i = group; i < group + group_size; ++i)
+            {
+                if (entries_[i].value < 0 || entries_[i].key == key)
+                {
+                    slot = i;
+                    break;
+                }
+            }
+            entries_[slot].key = key;
+            entries_[slot].value = value;
+        }
+
+        std::size_t capacity() const { return entries_.size(); }
+        uint64_t hits() const { return hits_; }
+        uint64_t misses() const { return misses_; }
+
+    private:
+        struct Entry
+        {
+            ChromosomeHash key;
+            int value = -1; // Fitness values are non-negative, -1 marks an empty slot.
+        };
+
+        static const std::size_t group_size = 4;
+        static const std::size_t num_stripes = 64;
+
+        std::size_t group_of(const ChromosomeHash &key) const { return key.lo & (entries_.size() - 1) & ~(group_size - 1); }
+        std::size_t stripe_of(std::size_t group) const { return (group / group_size) & (num_stripes - 1); }
+
+        std::vector<Entry> entries_;
+        std::mutex locks_[num_stripes];
+        std::atomic<uint64_t> hits_;
+        std::atomic<uint64_t> misses_;
+    };
+
+    //=================================================================================================
+    // Operator policies of the generation pipeline (GeneticAlgorithm::breed). They only choose the
+    // parents and the genes concerned; the pipeline applies the choice word by word on the free genes.
+
+    // Bits of word w whose genes lie in [first, last]
+    inline uint64_t range_mask(std::size_t w, std::size_t first, std::size_t last)
+    {
+        std::size_t lo = w << 6;
+        std::size_t hi = lo + 63;
+        if (first > last || first > hi || last < lo)
+            return 0;
+        uint64_t mask = ~0ULL;
+        if (first > lo)
+            mask &= ~0ULL << (first - lo);
+        if (last < hi)
+            mask &= ~0ULL >> (hi - last);
+        return mask;
+    }
+
+    // Binary tournaments: the fitter of two random individuals becomes a parent
+    struct TournamentSelection
+    {
+        template <class Rng>
+        static void select(const Population &population, std::size_t population_size, std::vector<std::size_t> &parents, Rng &rng)
+        {
+            parents.clear();
+            // Create a uniform distribution for integers in [0, population_size - 1]
+            std::uniform_int_distribution<int> dist(0, population_size - 1);
+            for (std::size_t i = 0; i < population_size / 2; ++i)
+            {
+                int index1 = dist(rng);
+                int index2 = dist(rng);
+                parents.push_back(population[index1].getFitness() < population[index2].getFitness() ? index1 : index2);
+            }
+        }
+    };
+
+    // Parents drawn uniformly from the population
+    struct RandomSelection
+    {
+        template <class Rng>
+        static void select(const Population &, std::size_t population_size, std::vector<std::size_t> &parents, Rng &rng)
+        {
+            parents.clear();
+            std::uniform_int_distribution<int> dist(0, population_size - 1);
+            for (std::size_t i = 0; i < population_size / 2; ++i)
+                parents.push_back(dist(rng));
+        }
+    };
+
+    // Cut points of the k-point crossovers, drawn in [1, nbits - 2]. With fewer than two genes
+    // there is nothing to cut: the crossovers exchange no gene and the children copy their parents.
+    inline std::uniform_int_distribution<int> cut_points(std::size_t nbits)
+    {
+        return std::uniform_int_distribution<int>(1, nbits < 3 ? 1 : nbits - 2);
+    }
+
+    // Exchange the genes [1, point]
+    class OnePointCrossover
+    {
+    public:
+        OnePointCrossover(std::size_t nbits, const std::vector<uint64_t> &) : dist(cut_points(nbits)), cut(nbits >= 3), point(0) {}
+        template <class Rng>
+        void draw(Rng &rng)
+        {
+            if (cut)
+                point = dist(rng);
+        }
+        uint64_t mask(std::size_t w) const { return cut ? range_mask(w, 1, point) : 0; }
+
+    private:
+        std::uniform_int_distribution<int> dist;
+        bool cut;
+        std::size_t point;
+    };
+
+    // Exchange the genes [1, point1] and [point2, end]
+    class TwoPointCrossover
+    {
+    public:
+        TwoPointCrossover(std::size_t nbits_, const std::vector<uint64_t> &) : dist(cut_points(nbits_)), cut(nbits_ >= 3), nbits(nbits_), point1(0), point2(0) {}
+        template <class Rng>
+        void draw(Rng &rng)
+        {
+            if (!cut)
+                return;
+            point1 = dist(rng);
+            point2 = dist(rng);
+            if (point1 > point2)
+                std::swap(point1, point2);
+        }
+        uint64_t mask(std::size_t w) const { return cut ? range_mask(w, 1, point1) | range_mask(w, point2, nbits - 1) : 0; }
+
+    private:
+        std::uniform_int_distribution<int> dist;
+        bool cut;
+        std::size_t nbits, point1, point2;
+    };
+
+    // Exchange the genes [1, point1] and [point2, point3]
+    class ThreePointCrossover
+    {
+    public:
+        ThreePointCrossover(std::size_t nbits, const std::vector<uint64_t> &) : dist(cut_points(nbits)), cut(nbits >= 3), point1(0), point2(0), point3(0) {}
+        template <class Rng>
+        void draw(Rng &rng)
+        {
+            if (!cut)
+                return;
+            point1 = dist(rng);
+            point2 = dist(rng);
+            point3 = dist(rng);
+            // sort the points
+            if (point1 > point2)
+                std::swap(point1, point2);
+            if (point2 > point3)
+                std::swap(point2, point3);
+            if (point1 > point2)
+                std::swap(point1, point2);
+        }
+        uint64_t mask(std::size_t w) const { return cut ? range_mask(w, 1, point1) | range_mask(w, point2, point3) : 0; }
+
+    private:
+        std::uniform_int_distribution<int> dist;
+        bool cut;
+        std::size_t point1, point2, point3;
+    };
+
+    // Exchange each gene with probability 1/2
+    class UniformCrossover
+    {
+    public:
+        UniformCrossover(std::size_t nbits, const std::vector<uint64_t> &) : words(Solution::num_words(nbits), 0) {}
+        template <class Rng>
+        void draw(Rng &rng)
+        {
+            for (uint64_t &word : words)
+                word = rng();
+        }
+        uint64_t mask(std::size_t w) const { return words[w]; }
+
+    private:
+        std::vector<uint64_t> words;
+    };
+
+    // Exchange the degree centrality variables as one block
+    class MaskCrossover
+    {
+    public:
+        MaskCrossover(std::size_t, const std::vector<uint64_t> &centrality_mask) : words(centrality_mask) {}
+        template <class Rng>
+        void draw(Rng &) {}
+        uint64_t mask(std::size_t w) const { return words[w]; }
+
+    private:
+        const std::vector<uint64_t> &words;
+    };
+
+    // Positions of the successes in a sequence of Bernoulli(p) trials, drawn as geometric gaps so that
+    // the cost is one random number per success instead of one per trial
+    class GeometricSkip
+    {
+    public:
+        explicit GeometricSkip(double p_) : p(p_), log_q(p_ > 0 && p_ < 1 ? std::log1p(-p_) : 0), dist(0.0, 1.0) {}
+
+        // Number of failed trials before the next success, at least 'limit' when it is out of reach
+        template <class Rng>
+        std::size_t next(Rng &rng, std::size_t limit)
+        {
+            if (p >= 1)
+                return 0;
+            if (p <= 0)
+                return limit;
+            double gap = std::floor(std::log1p(-dist(rng)) / log_q);
+            return gap < (double)limit ? (std::size_t)gap : limit;
+        }
+
+    private:
+        double p;
+        double log_q;
+        std::uniform_real_distribution<double> dist;
+    };
+
+    // Flip each degree centrality variable with probability 'rate' (or rate / #variables per chromosome)
+    class CentralityMutation
+    {
+    public:
+        CentralityMutation(float rate, bool per_chromosome, const std::vector<unsigned> &vars_, const std::vector<uint64_t> &,
+                           std::size_t nbits_)
+            : skip(per_chromosome ? (double)rate / std::max<std::size_t>(vars_.size(), 1) : rate), vars(vars_), nbits(nbits_)
+        {
+        }
+        // Set the bits of the genes to flip in mask, return false if there is none
+        template <class Rng>
+        bool draw(std::vector<uint64_t> &mask, Rng &rng)
+        {
+            bool any = false;
+            for (std::size_t i = 0;; ++i)
+            {
+                i += skip.next(rng, vars.size() - i);
+                if (i >= vars.size())
+                    break;
+                if (vars[i] < nbits)
+                {
+                    mask[Solution::word_index(vars[i])] |= Solution::bit_mask(vars[i]);
+                    any = true;
+                }
+            }
+            return any;
+        }
+
+    private:
+        GeometricSkip skip;
+        const std::vector<unsigned> &vars;
+        std::size_t nbits;
+    };
+
+    // Flip each free variable with probability 'rate' (or rate / #free variables per chromosome)
+    class UniformMutation
+    {
+    public:
+        UniformMutation(float rate, bool per_chromosome, const std::vector<unsigned> &, const std::vector<uint64_t> &free_mask_,
+                        std::size_t nbits_)
+            : skip(per_chromosome ? (double)rate / std::max<std::size_t>(count_free(free_mask_), 1) : rate), free_mask(free_mask_),
+              nbits(nbits_)
+        {
+        }
+        // Fixed genes are skipped like the others and then dropped, which keeps the rate of the free ones
+        template <class Rng>
+        bool draw(std::vector<uint64_t> &mask, Rng &rng)
+        {
+            bool any = false;
+            for (std::size_t j = 1;; ++j)
+            {
+                j += skip.next(rng, nbits - j);
+                if (j >= nbits)
+                    break;
+                if (free_mask[Solution::word_index(j)] & Solution::bit_mask(j))
+                {
+                    mask[Solution::word_index(j)] |= Solution::bit_mask(j);
+                    any = true;
+                }
+            }
+            return any;
+        }
+
+    private:
+        static std::size_t count_free(const std::vector<uint64_t> &free_mask)
+        {
+            std::size_t count = 0;
+            for (uint64_t word : free_mask)
+                count += __builtin_popcountll(word);
+            return count;
+        }
+
+        GeometricSkip skip;
+        const std::vector<uint64_t> &free_mask;
+        std::size_t nbits;
+    };
+
+    class GeneticAlgorithm;
+
+    // How the individuals of a generation got their fitness
+    struct EvaluationCounts
+    {
+        EvaluationCounts() : full(0), delta(0), inherited(0), cached(0) {}
+
+        uint64_t full;      // Scored from scratch (or found in the cache).
+        uint64_t delta;     // Updated from the clauses of their changed genes.
+        uint64_t inherited; // Unchanged copies of their parent, nothing to do.
+        uint64_t cached;    // Full evaluations answered by the cache.
+
+        EvaluationCounts &operator+=(const EvaluationCounts &other)
+        {
+            full += other.full;
+            delta += other.delta;
+            inherited += other.inherited;
+            cached += other.cached;
+            return *this;
+        }
+    };
+
+    // Wall-clock time of the steps of a generation, only measured for the telemetry
+    struct GenerationTimes
+    {
+        GenerationTimes() : selection(0), crossover(0), mutation(0), evaluation(0), improvement(0) {}
+
+        double selection;
+        double crossover;
+        double mutation;
+        double evaluation;
+        double improvement;
+    };
+
+    // Seconds between two calls of lap(), or 0 when disabled so that untimed runs skip the clock
+    class Stopwatch
+    {
+    public:
+        explicit Stopwatch(bool enabled_) : enabled(enabled_)
+        {
+            if (enabled)
+                last = std::chrono::steady_clock::now();
+        }
+
+        double lap()
+        {
+            if (!enabled)
+                return 0;
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(now - last).count();
+            last = now;
+            return seconds;
+        }
+
+    private:
+        bool enabled;
+        std::chrono::steady_clock::time_point last;
+    };
+
+    // One sub-population of the island model. Islands evolve independently, each with its own
+    // random stream, crossover operator and generation buffers, and only exchange migrants.
+    struct Island
+    {
+        typedef std::size_t (GeneticAlgorithm::*Breeder)(Island &);
+
+        explicit Island(std::size_t population_size)
+            : population(population_size), breed(nullptr), pool(nullptr), generations(0), best_fitness(INT32_MAX), stalled(0),
+              next_population(population_size), stamp(0)
+        {
+        }
+
+        Population population;
+        Xoshiro256 rng;   // Stream of this island, drawn from by every operator of the island.
+        Breeder breed;    // Generation pipeline with the operators of this island.
+        ThreadPool *pool; // Workers for the fitness evaluation of this island, null when sequential.
+        int generations;  // Generations evolved so far.
+        int best_fitness; // Best fitness seen on this island.
+        int stalled;      // Generations since best_fitness last improved.
+        EvaluationCounts evaluations;      // Since the island was created.
+        EvaluationCounts last_evaluations; // Of the last generation.
+        GenerationTimes times;             // Of the last generation, when recorded by the telemetry.
+
+        // Generation buffers, allocated once in solve() and reused by every generation
+        std::vector<std::size_t> parents; // Indices of the selected parents in population.
+        std::vector<Solution> offspring;  // Children of the current generation.
+        Population next_population;       // Receives the survivors, then swapped with population.
+        std::vector<std::size_t> order;   // Candidate indices into population followed by offspring.
+        std::vector<ChromosomeHash> seen; // Open-addressing set of the hashes seen by collect_candidates.
+        std::vector<uint32_t> seen_stamp; // A slot of seen is in use iff its stamp equals stamp.
+        uint32_t stamp;
+        std::vector<uint64_t> mutation_mask; // Scratch mask of the genes selected for mutation (kept cleared).
+        std::vector<uint64_t> lanes;         // Transposed chromosomes of the batch being bit-slice evaluated.
+        std::vector<Solution *> batch;       // Individuals handed to the bit-sliced kernel.
+        std::vector<Solution *> updates;     // Individuals handed to the delta evaluation.
+    };
+
     class GeneticAlgorithm
     {
     public:
-        GeneticAlgorithm(int population_size, int solution_size, int max_iterations, float mutation_rate,
-                         float crossover_rate, Formula &formula, Minisat::Solver &solver)
+        typedef Island::Breeder Breeder;
+
+        enum SelectionOperator
+        {
+            SELECT_TOURNAMENT,
+            SELECT_RANDOM
+        };
+
+        enum CrossoverOperator
+        {
+            CROSSOVER_CYCLE, // Islands cycle through the one, two and three points crossovers.
+            CROSSOVER_ONE_POINT,
+            CROSSOVER_TWO_POINTS,
+            CROSSOVER_THREE_POINTS,
+            CROSSOVER_UNIFORM,
+            CROSSOVER_MASK
+        };
+
+        enum MutationOperator
+        {
+            MUTATE_CENTRALITY, // Degree centrality variables only.
+            MUTATE_ALL
+        };
+
+        enum InitOperator
+        {
+            INIT_RANDOM,     // Every gene is a coin flip.
+            INIT_PROPAGATION // Random decisions and unit propagation (UnitRepair::dive()).
+        };
+
+        enum StopReason
+        {
+            STOP_NONE,        // Still running.
+            STOP_GENERATIONS, // Generation limit reached.
+            STOP_SOLVED,      // A model was found.
+            STOP_TIME,        // Time budget exhausted.
+            STOP_STAGNATION,  // No island improved its best fitness for the stagnation limit.
+            STOP_INTERRUPTED  // Stopped by interrupt().
+        };
+
+        GeneticAlgorithm(int population_size, int max_iterations, float mutation_rate, float crossover_rate,
+                         Formula &formula, Minisat::Solver &solver)
             : population_size_(population_size),
-              solution_size_(solution_size + 1),
+              solution_size_(0),
               max_iterations_(max_iterations),
               mutation_rate_(mutation_rate),
               crossover_rate_(crossover_rate),
-              population_(population_size),
               formula_(formula),
-              solver_(solver)
+              solver_(solver),
+              incremental_(false),
+              ls_steps_(0),
+              ls_elite_only_(false),
+              repair_(false),
+              init_mode_(INIT_RANDOM),
+              selection_(SELECT_TOURNAMENT),
+              crossover_(CROSSOVER_CYCLE),
+              mutation_(MUTATE_CENTRALITY),
+              mutation_per_chromosome_(false),
+              learnt_tiers_(0),
+              learnt_weight_(1),
+              weight_interval_(0),
+              weight_updates_(0),
+              cache_epoch_(0),
+              cache_(4096),
+              bitsliced_(false),
+              num_islands_(1),
+              migration_interval_(10),
+              num_migrants_(2),
+              random_topology_(false),
+              seed_(-1),
+              runs_(0),
+              time_limit_(0),
+              stagnation_limit_(0),
+              start_time_(),
+              stop_reason_(STOP_NONE),
+              gaspi_(nullptr),
+              mailbox_free_(true),
+              published_best_(-1),
+              phases_(nullptr),
+              telemetry_(nullptr)
         {
-            population_ = Population(population_size_);
+            genes_.build(solver_, formula_);
+            solution_size_ = genes_.size();
+            build_free_mask();
+            view_.build(solver_, genes_);
+            evaluator_.build(view_, solution_size_);
         }
         ~GeneticAlgorithm() {}
 
         Solution solve()
         {
-            // Create a random number generator with a fixed seed for reproducibility
-            std::random_device rd;
-            std::mt19937 rng(rd());
-            std::cout << "c |  Initializing the population ..." << std::endl;
-            initialize_population(rng);
+            start_time_ = std::chrono::steady_clock::now();
+            restart();
+            if (max_iterations_ <= 0)
+                max_iterations_ = auto_generations();
 
-            evaluate_fitness();
+            create_islands();
+            if (gaspi_)
+                create_exchange();
+            if (!gaspi_ || gaspi_->rank() == 0)
+                std::cout << "c |  Initializing the population ..." << std::endl;
+            for_each_island([this](Island &island)
+                            {
+                                initialize_population(island);
+                                prepare_island(island);
+                            });
+            return run(max_iterations_);
+        }
 
-            for (int iteration = 0; iteration < max_iterations_; ++iteration)
-            {
-                std::vector<Solution> parents = select_parents_tournament(rng);
+        // Short run started from 'seeds' instead of random chromosomes, the rest of each population being
+        // copies of them with a few genes flipped (e.g. to refine the phases of a solver). Single process.
+        Solution refine(const std::vector<Solution> &seeds, int generations);
 
-                std::vector<Solution> offspring = create_offspring(parents, rng);
+        // std::unordered_map<Solution, int, SolutionHash> cache_memo{};       // cache memory to store the results of previous calls to fitness_unsat
 
-                evaluate_fitness(offspring);
-                select_survivors_ellitist(offspring);
+        // Keep per-clause counters for every individual and derive offspring fitness incrementally
+        void setIncremental(bool incremental) { incremental_ = incremental; }
 
-                // Clear the parents and offspring vectors
-                parents.clear();
-                offspring.clear();
-                parents.shrink_to_fit();
-                offspring.shrink_to_fit();
+        // Improve the offspring with 'steps' local search flips each (0 disables it). With 'elite_only',
+        // only the children at least as fit as the elite half of the population are improved.
+        void setLocalSearch(int steps, bool elite_only)
+        {
+            ls_steps_ = steps;
+            ls_elite_only_ = elite_only;
+            if (ls_steps_ > 0 && !local_search_.ready())
+                local_search_.build(view_, evaluator_);
+        }
 
-                // Check if a solution has been found
-                if (solution_found())
-                    break;
+        // Make every child (and the initial individuals) consistent with unit propagation before scoring
+        // it, deciding the genes in centrality order
+        void setRepair(bool repair)
+        {
+            repair_ = repair;
+            if (repair_)
+                build_unit_repair();
+        }
 
-                // if (iteration % 10 == 0)
-                // {
-                //     std::cout << "c |  Iteration " << iteration << std::endl
-                //               << "c |  Best fitness: " << population_[0].getFitness() << std::endl
-                //               << "c |  Worst fitness: " << population_.getPopulation().back().getFitness() << std::endl;
-                //     std::cout << "c |  \t ==================================== " << std::endl;
-                // }
-            }
+        // How solve() creates the initial individuals (InitOperator value)
+        void setInitialization(int mode)
+        {
+            init_mode_ = mode;
+            if (init_mode_ == INIT_PROPAGATION)
+                build_unit_repair();
+        }
 
-            return population_[0];
+        // Let refine() also score the learnt clauses of the solver: the core tier (tiers >= 1) and the
+        // tier2 (tiers >= 2), each unsatisfied one counting 'weight'. The raw fitness only counts the
+        // original clauses, it is 0 whenever the fitness is.
+        void setLearnts(int tiers, int weight)
+        {
+            learnt_tiers_ = tiers;
+            learnt_weight_ = weight < 1 ? 1 : weight;
         }
+        int rawFitness(const Solution &solution) const;
 
-        boost::compute::detail::lru_cache<std::vector<unsigned>, int> memo{500}; // cache memory to store the results of previous calls to fitness_unsat
-        // std::unordered_map<Solution, int, SolutionHash> cache_memo{};       // cache memory to store the results of previous calls to fitness_unsat
+        // Clause weighting (0 = off): every 'interval' generations, or at every migration, each clause
+        // left unsatisfied by the fittest individual of some island gains weight, and the fitness becomes
+        // the weight of the unsatisfied clauses. The solutions found, published and returned are still
+        // compared by raw fitness.
+        void setClauseWeighting(int interval) { weight_interval_ = interval; }
+
+        // Genetic operators (SelectionOperator, CrossoverOperator and MutationOperator values)
+        void setOperators(int selection, int crossover, int mutation)
+        {
+            selection_ = selection;
+            crossover_ = crossover;
+            mutation_ = mutation;
+        }
+
+        // Read the mutation rate as the expected number of flips per chromosome instead of per gene
+        void setMutationPerChromosome(bool per_chromosome) { mutation_per_chromosome_ = per_chromosome; }
+
+        // Score whole batches of individuals at once with the bit-sliced kernel
+        void setBitsliced(bool bitsliced) { bitsliced_ = bitsliced; }
+
+        // Number of fitness values kept by the cache (0 disables it)
+        void setCacheCapacity(std::size_t capacity) { cache_.resize(capacity); }
+        uint64_t getCacheHits() const { return cache_.hits(); }
+        uint64_t getCacheMisses() const { return cache_.misses(); }
+
+        // Evaluations of all islands in the last solve(), in total and in their last generation
+        EvaluationCounts getEvaluations() const
+        {
+            EvaluationCounts counts;
+            for (const Island &island : islands_)
+                counts += island.evaluations;
+            return counts;
+        }
+        EvaluationCounts getLastEvaluations() const
+        {
+            EvaluationCounts counts;
+            for (const Island &island : islands_)
+                counts += island.last_evaluations;
+            return counts;
+        }
+
+        // Evolve this many sub-populations, exchanging 'migrants' individuals every 'interval' generations
+        // along a ring (or towards random islands). The islands run concurrently on the thread pool.
+        void setIslands(int num_islands, int interval, int migrants, bool random_topology)
+        {
+            num_islands_ = num_islands < 1 ? 1 : num_islands;
+            migration_interval_ = interval;
+            num_migrants_ = migrants;
+            random_topology_ = random_topology;
+        }
+
+        // Seed of the random streams, runs with the same seed and settings are identical (-1 = random)
+        void setSeed(int64_t seed) { seed_ = seed; }
+
+        // Stop after 'time_limit' seconds of wall-clock time (0 = no limit), or once no island improved
+        // its best fitness for 'stagnation_limit' generations (0 = never). Wall-clock time, as the process
+        // CPU time also counts the evaluation threads, the other islands and a solver running meanwhile.
+        void setTermination(double time_limit, int stagnation_limit)
+        {
+            time_limit_ = time_limit;
+            stagnation_limit_ = stagnation_limit;
+        }
+        StopReason getStopReason() const { return (StopReason)stop_reason_.load(); }
+        const char *getStopReasonName() const
+        {
+            static const char *names[] = {"running", "generations", "solved", "time budget", "stagnation", "interrupted"};
+            return names[stop_reason_.load()];
+        }
+        int getMaxGenerations() const { return max_iterations_; }
+        // Most generations evolved by an island in the last solve()
+        int getGenerations() const
+        {
+            int generations = 0;
+            for (const Island &island : islands_)
+                generations = std::max(generations, island.generations);
+            return generations;
+        }
+
+        // Run the islands of this process as one rank of a multi-process job: migrants travel along
+        // the ring of ranks and every rank learns the best fitness of the others. solve() is collective
+        // and returns the best solution of the whole job on rank 0.
+        void setContext(Gaspi::Context *gaspi) { gaspi_ = gaspi; }
+
+        // Record the statistics of every generation of every island in 'telemetry' (null = none)
+        void setTelemetry(Telemetry *telemetry) { telemetry_ = telemetry; }
+
+        // Publish every improvement of the best fitness to 'phases', for a solver searching meanwhile
+        void setPhaseExchange(PhaseExchange *phases) { phases_ = phases; }
+        // Make a solve() running on another thread return after the current generation. The interrupt
+        // is sticky: a solve() or refine() started after it returns at once.
+        void interrupt() { stop(STOP_INTERRUPTED); }
+
+        // Evaluate the individuals of a population (or run the islands) on this many threads
+        void setNumThreads(int num_threads)
+        {
+            pool_.reset(num_threads > 1 ? new ThreadPool(num_threads) : nullptr);
+        }
 
         Solution &getBestSolution();
         Solution &getWorstSolution();
+        const GeneMap &getGeneMap() const { return genes_; }
 
     private:
         size_t population_size_;
@@ -387,30 +1309,183 @@ namespace SAGA
         int max_iterations_;
         float mutation_rate_;
         float crossover_rate_;
-        Population population_;
         Formula formula_;
         Minisat::Solver &solver_;
+        GeneMap genes_;                       // Variables of the chromosome, solution_size_ genes.
+        ClauseView view_;                     // Clauses scanned by fitness().
+        IncrementalEvaluator evaluator_;      // Occurrence index over view_: counters if incremental_ is set, delta evaluation.
+        bool incremental_;
+        LocalSearch local_search_;            // Memetic step, used when ls_steps_ > 0.
+        int ls_steps_;
+        bool ls_elite_only_;
+        UnitRepair unit_repair_;              // Repair operator, used when repair_ is set or to initialize by propagation.
+        bool repair_;
+        int init_mode_;
+        int selection_;
+        int crossover_;
+        int mutation_;
+        bool mutation_per_chromosome_;
+        int learnt_tiers_;  // Learnt clause tiers added to the view by refine() (0 = none).
+        int learnt_weight_;
+        int weight_interval_;
+        int weight_updates_;
+        std::vector<std::pair<uint32_t, int>> weight_deltas_; // Clauses whose weight changed, and by how much.
+        uint64_t cache_epoch_; // Changes with the fitness function, cached values of other epochs are never hit.
+        FitnessCache cache_;                  // Fitness values of recently evaluated chromosomes.
+        bool bitsliced_;
+
+        // Island model
+        std::size_t num_islands_;
+        int migration_interval_;
+        int num_migrants_;
+        bool random_topology_;
+        std::vector<Island> islands_;
+        std::vector<Solution> migrants_; // Copies of the individuals sent during a migration.
+        Xoshiro256 migration_rng_;       // Draws the destinations of the random topology.
+        int64_t seed_;
+        uint64_t runs_; // Calls of create_islands(), so that every run gets new streams.
+
+        // Termination
+        double time_limit_;
+        int stagnation_limit_;
+        std::chrono::steady_clock::time_point start_time_; // Start of the current solve() or refine().
+        std::atomic<int> stop_reason_; // StopReason, only the first reason is kept.
 
-        void initialize_population(std::mt19937 rng);
-        void evaluate_fitness(std::vector<Solution> &offspring);
-        void evaluate_fitness();
+        // Exchange between the processes of a multi-process job (segment layout in create_exchange())
+        Gaspi::Context *gaspi_;
+        std::size_t entry_size_; // Bytes of one individual in the segment (fitness then chromosome words).
+        std::size_t nsent_;      // Number of individuals sent per migration between processes.
+        bool mailbox_free_;      // The next rank consumed the last migrants we sent.
+        int published_best_;     // Best fitness announced to the other ranks (-1 if none yet).
+
+        PhaseExchange *phases_; // Receives the best solutions while solve() runs, null if none.
+        Telemetry *telemetry_;  // Receives the statistics of every generation, null if none.
+
+        std::unique_ptr<ThreadPool> pool_; // Workers for the fitness evaluation or the islands, null when sequential.
+        std::vector<uint64_t> free_mask_;  // Bit j is set iff variable j may be changed by the genetic operators.
+        std::vector<unsigned> centrality_genes_; // Degree centrality variables that have a gene, as genes.
+        std::vector<uint64_t> centrality_mask_;  // Bit j is set iff gene j is in centrality_genes_.
+
+        void create_islands();
+        void update_learnts();
+        void update_weights();
+        void publish_best(Island &island);
+        // Fitness the results are compared on: the raw one when clause weighting is on
+        int objective(const Solution &solution) const
+        {
+            return weight_interval_ > 0 ? rawFitness(solution) : solution.getFitness();
+        }
+        ChromosomeHash cache_key(const Solution &solution) const
+        {
+            ChromosomeHash key = solution.getHash();
+            key.lo ^= ChromosomeHash::mix(cache_epoch_);
+            key.hi ^= ChromosomeHash::mix(cache_epoch_ * 0x9E3779B97F4A7C15ULL);
+            return key;
+        }
+        void prepare_island(Island &island);
+        void seed_population(Island &island, const std::vector<Solution> &seeds);
+        Solution run(int max_generations);
+        void for_each_island(const std::function<void(Island &)> &body);
+        void evolve(Island &island, int generations);
+        void migrate();
+        int auto_generations() const;
+        void stop(StopReason reason)
+        {
+            int running = STOP_NONE;
+            stop_reason_.compare_exchange_strong(running, reason);
+        }
+        // Clear the stop reason of the previous run, unless interrupt() was called
+        void restart()
+        {
+            int reason = stop_reason_.load();
+            while (reason != STOP_INTERRUPTED && !stop_reason_.compare_exchange_weak(reason, STOP_NONE))
+                ;
+        }
+        bool stopped() const { return stop_reason_ != STOP_NONE; }
+        // Wall-clock seconds since the start of the current run
+        double elapsed() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count(); }
+        bool stagnated() const;
+        void accept_migrants(Population &population, Solution *migrants, std::size_t count);
+        void create_exchange();
+        void exchange();
+        Solution gather();
+        void pack(const Solution &solution, std::size_t offset);
+        void unpack(Solution &solution, std::size_t offset);
+        void for_each_individual(Island &island, std::size_t n, const std::function<void(std::size_t)> &body);
+        void build_free_mask();
+        void initialize_population(Island &island);
+        void initialize_propagated(Island &island);
+        void build_unit_repair()
+        {
+            if (!unit_repair_.ready())
+                unit_repair_.build(view_, evaluator_, centrality_genes_, solution_size_);
+        }
+        void evaluate_fitness(Island &island, std::vector<Solution> &offspring, std::size_t count);
+        void evaluate_fitness(Island &island);
         int fitness(Solution &solution);
-        Solution select_parent(std::mt19937 rng);
-        std::vector<Solution> create_offspring_two_points(std::mt19937 rng);
-        std::vector<Solution> create_offspring_three_points(std::mt19937 rng);
-        std::vector<Solution> create_offspring(std::mt19937 rng);
-        void mutate(Solution &solution, std::mt19937 rng);
-        std::vector<Solution> select_parents_tournament(std::mt19937 rng);
-        std::vector<Solution> select_parents_random(std::mt19937 rng);
-        std::vector<Solution> create_offspring(const std::vector<Solution> &parents, std::mt19937 rng);
-        std::vector<Solution> create_offspring_two_points(const std::vector<Solution> &parents, std::mt19937 rng);
-        std::vector<Solution> create_offspring_three_points(const std::vector<Solution> &parents, std::mt19937 rng);
-        void select_survivors(const std::vector<Solution> &offspring);
-        void select_survivors_ellitist(const std::vector<Solution> &offspring);
-        bool solution_found();
+        bool delta_worthwhile(const Solution &solution) const;
+        int score(const Solution &solution) const;
+        std::size_t lookup_cached(std::vector<Solution *> &batch);
+        void evaluate_bitsliced(Island &island, std::vector<Solution *> &batch);
+        void record(Island &island);
+        void improve_offspring(Island &island, std::size_t count);
+        void repair_offspring(Island &island, std::size_t count);
+        template <class Selection, class Crossover, class Mutation>
+        std::size_t breed(Island &island);
+        template <class Selection, class Crossover>
+        static Breeder breeder_for(int mutation);
+        template <class Selection>
+        static Breeder breeder_for(int crossover, int mutation);
+        static Breeder breeder(int selection, int crossover, int mutation);
+        Solution &combined(Island &island, std::size_t i)
+        {
+            return i < population_size_ ? island.population[i] : island.offspring[i - population_size_];
+        }
+        void collect_candidates(Island &island, std::size_t noffspring);
+        void select_elite(Island &island, std::size_t elite);
+        void install_survivors(Island &island, std::size_t count);
+        void select_survivors_ellitist(Island &island, std::size_t noffspring);
+        bool solution_found(Island &island);
     };
 
-    void initialize_polarity(Solution &solution, Minisat::Solver &solver);
+    void initialize_polarity(Solution &solution, const GeneMap &genes, Minisat::Solver &solver);
+
+    // Periodic rephasing of a CDCL solver: every 'interval' restarts, a short GA run seeded with the
+    // saved phases and the phases of the longest trail replaces the saved phases. While rephasing raises
+    // the conflict rate, rephasing gets more frequent and the GA more generations, otherwise the reverse,
+    // the GA keeping at least a quarter of its initial generations.
+    class Rephaser : public Minisat::PhaseHook
+    {
+    public:
+        Rephaser(GeneticAlgorithm &ga_, int interval_, int generations_)
+            : ga(ga_), interval(interval_), generations(generations_), min_generations(std::max(generations_ / 4, 1)),
+              next(interval_), window_start(Minisat::cpuTime()),
+              window_conflicts(0), last_rate(-1), rephases(0), raw_fitness(-1)
+        {
+        }
+
+        bool rephase(Minisat::vec<char> &polarity, const Minisat::vec<char> &best, uint64_t restarts, uint64_t conflicts);
+        bool usesBestPhases() const { return true; }
+
+        uint64_t getRephases() const { return rephases; }
+        int getInterval() const { return interval; }
+        int getGenerations() const { return generations; }
+        int getRawFitness() const { return raw_fitness; } // Of the last refined phases (-1 if none).
+
+    private:
+        Solution from_phases(const Minisat::vec<char> &phases) const;
+
+        GeneticAlgorithm &ga;
+        int interval;              // Restarts between two rephasings.
+        int generations;           // GA budget of a rephasing.
+        int min_generations;       // Floor of that budget.
+        uint64_t next;             // Restart count of the next rephasing.
+        double window_start;       // CPU time at the end of the last rephasing.
+        uint64_t window_conflicts; // Conflicts at the end of the last rephasing.
+        double last_rate;          // Conflicts per second after the previous rephasing (-1 if none).
+        uint64_t rephases;
+        int raw_fitness;
+    };
 
 }
 
@@ -28,11 +28,13 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include <string>
 #include <vector>
 #include <iomanip>
+#include <thread>
 
 #include "utils/System.h"
 #include "utils/ParseUtils.h"
 #include "utils/Options.h"
 #include "core/Dimacs.h"
+#include "core/Centrality.h"
 #include "simp/SimpSolver.h"
 
 using namespace Minisat;
@@ -106,9 +108,41 @@ int main(int argc, char **argv)
         // BoolOption opt_symmetry("MAIN", "symmetry", "Use of symmetry in SAGA initialization (0=False, 1=True)", false);
 
         IntOption population_size("MAIN", "pop-size", "Size of a population.\n", 20, IntRange(0, INT32_MAX));
-        IntOption max_generations("MAIN", "max-generations", "Number of maximum generations.\n", 200, IntRange(0, INT32_MAX));
-        DoubleOption mutation_rate("MAIN", "mutation-rate", "Mutation rate.\n", 0.88, DoubleRange(0, true, 1, true));
+        IntOption saga_threads("MAIN", "saga-threads", "Number of threads evaluating the SAGA population.\n", 1, IntRange(1, 1024));
+        IntOption max_generations("MAIN", "max-generations", "Number of maximum generations (0=scaled to clauses x pop-size).\n", 0, IntRange(0, INT32_MAX));
+        DoubleOption mutation_rate("MAIN", "mutation-rate", "Mutation rate (per gene, or per chromosome with -saga-mutation-per-chromosome).\n", 0.88, DoubleRange(0, true, HUGE_VAL, false));
         DoubleOption crossover_rate("MAIN", "crossover-rate", "Crossover rate.\n", 0.92, DoubleRange(0, true, 1, true));
+        IntOption saga_cache("MAIN", "saga-cache", "Number of entries of the SAGA fitness cache (0=off).\n", 4096, IntRange(0, INT32_MAX));
+        BoolOption saga_bitslice("MAIN", "saga-bitslice", "Evaluate the SAGA population with the bit-sliced (SIMD) kernel.", false);
+        BoolOption saga_incremental("MAIN", "saga-incremental", "Derive offspring fitness incrementally from per-clause counters.", false);
+        IntOption saga_islands("MAIN", "saga-islands", "Number of SAGA islands (sub-populations of pop-size each).\n", 1, IntRange(1, 1024));
+        IntOption saga_migration_interval("MAIN", "saga-migration-interval", "Generations between two migrations of SAGA islands.\n", 10, IntRange(1, INT32_MAX));
+        IntOption saga_migrants("MAIN", "saga-migrants", "Number of individuals sent by each SAGA island per migration.\n", 2, IntRange(0, INT32_MAX));
+        BoolOption saga_random_migration("MAIN", "saga-random-migration", "Send SAGA migrants to random islands instead of along a ring.", false);
+        IntOption saga_selection("MAIN", "saga-selection", "SAGA parent selection (0=binary tournament, 1=random).\n", 0, IntRange(0, 1));
+        IntOption saga_crossover("MAIN", "saga-crossover", "SAGA crossover (0=islands cycle 1-3, 1=one point, 2=two points, 3=three points, 4=uniform, 5=mask).\n", 0, IntRange(0, 5));
+        IntOption saga_mutation("MAIN", "saga-mutation", "Variables mutated by SAGA (0=centrality, 1=all free).\n", 0, IntRange(0, 1));
+        IntOption saga_centrality("MAIN", "saga-centrality", "Centrality of the SAGA mutated variables (0=occurrences, 1=degree, 2=betweenness, 3=pagerank).\n", 0, IntRange(0, 3));
+        DoubleOption saga_centrality_top("MAIN", "saga-centrality-top", "Fraction of the variables, most central first, mutated by SAGA.\n", 0.1, DoubleRange(0, false, 1, true));
+        IntOption saga_betweenness_samples("MAIN", "saga-betweenness-samples", "BFS sources sampled by the betweenness estimate.\n", 64, IntRange(1, INT32_MAX));
+        BoolOption saga_mutation_chromosome("MAIN", "saga-mutation-per-chromosome", "Read mutation-rate as expected SAGA flips per chromosome, not per gene.", false);
+        IntOption saga_ls_steps("MAIN", "saga-ls-steps", "Local search flips applied to each SAGA child (0=off).\n", 0, IntRange(0, INT32_MAX));
+        IntOption saga_init("MAIN", "saga-init", "Initial SAGA individuals (0=random, 1=random decisions and unit propagation).\n", 0, IntRange(0, 1));
+        BoolOption saga_repair("MAIN", "saga-repair", "Make the SAGA individuals consistent with unit propagation before scoring them.", false);
+        BoolOption saga_ls_elite("MAIN", "saga-ls-elite", "Only improve the SAGA children that reach the elite half.", false);
+        DoubleOption saga_time("MAIN", "saga-time", "Wall-clock time budget of SAGA in seconds (0=none).\n", 0, DoubleRange(0, true, HUGE_VAL, false));
+        DoubleOption saga_time_frac("MAIN", "saga-time-frac", "Wall-clock time budget of SAGA as a fraction of cpu-lim (0=none).\n", 0, DoubleRange(0, true, 1, true));
+        IntOption saga_stagnation("MAIN", "saga-stagnation", "Stop SAGA after this many generations without improvement (0=never).\n", 0, IntRange(0, INT32_MAX));
+        IntOption saga_seed("MAIN", "saga-seed", "Seed of the SAGA random streams (-1=random).\n", -1, IntRange(-1, INT32_MAX));
+        BoolOption saga_background("MAIN", "saga-background", "Run SAGA on its own thread during the search, phases are taken at restarts.", false);
+        IntOption saga_rephase("MAIN", "saga-rephase", "Refine the saved phases with a short SAGA run every this many restarts (0=never).\n", 0, IntRange(0, INT32_MAX));
+        IntOption saga_rephase_gens("MAIN", "saga-rephase-gens", "Initial number of SAGA generations of a rephasing.\n", 20, IntRange(1, 1000));
+        IntOption saga_learnts("MAIN", "saga-learnts", "Learnt clauses scored by SAGA rephasing (0=none, 1=core, 2=core+tier2).\n", 0, IntRange(0, 2));
+        IntOption saga_learnt_weight("MAIN", "saga-learnt-weight", "Fitness weight of an unsatisfied learnt clause.\n", 1, IntRange(1, 1000));
+        IntOption saga_weighting("MAIN", "saga-weighting", "Update the SAGA clause weights every this many generations (0=off).\n", 0, IntRange(0, INT32_MAX));
+        StringOption saga_telemetry("MAIN", "saga-telemetry", "Write the statistics of every SAGA generation to this file.");
+        IntOption saga_telemetry_format("MAIN", "saga-telemetry-format", "Format of the SAGA telemetry (0=CSV, 1=JSON lines).\n", 0, IntRange(0, 1));
+        IntOption saga_procs("MAIN", "saga-procs", "Number of processes running SAGA islands (POSIX shared memory).\n", 1, IntRange(1, 256));
 
         parseOptions(argc, argv, true);
 
@@ -182,22 +216,15 @@ int main(int argc, char **argv)
             printf("c |                                                                             |\n");
         }
         SAGA::Formula formula;
+        SAGA::GeneticAlgorithm *background_ga = NULL;
+        std::unique_ptr<SAGA::PhaseExchange> phases;
+        std::thread saga_thread;
+        std::unique_ptr<SAGA::Rephaser> rephaser;
+        std::unique_ptr<SAGA::Telemetry> telemetry;
         // SAGA
 
-        std::string filename = argv[1];
         if (S.use_saga)
-        {
-
-            // std::cout << "c Centrality variables file: " << file_in << std::endl;
             parse_DIMACS(in, S, formula);
-            // std::cout << "c SAGA initialization is activated" << std::endl;
-            // std::string command_line = "python3 cnf2graph.py betweenness " + filename;
-            // std::system(command_line.c_str());
-            // std::string file_in = filename + ".important";
-            // formula.read_important_variables(file_in);
-            // command_line = "rm " + file_in;
-            // std::system(command_line.c_str());
-        }
         else
         {
             parse_DIMACS(in, S);
@@ -218,6 +245,23 @@ int main(int argc, char **argv)
         if (S.verbosity > 0)
             printf("c |  Parse time:           %12.2f s                                       |\n", parsed_time - initial_time);
 
+        if (S.use_saga)
+        {
+            // SAGA mutates the most central variables of the formula, before simplification
+            SAGA::VariableGraph graph;
+            graph.build(S);
+            std::unique_ptr<SAGA::ThreadPool> pool(saga_threads > 1 ? new SAGA::ThreadPool(saga_threads) : nullptr);
+            SAGA::Centrality centrality(graph, pool.get());
+            std::vector<double> scores = centrality.scores(saga_centrality, saga_betweenness_samples);
+            std::size_t k = std::max<std::size_t>(1, saga_centrality_top * (graph.size() - 1));
+            std::vector<unsigned> central = centrality.top(scores, k);
+            formula.set_degree_centrality_variables(central);
+            double centrality_time = cpuTime();
+            if (S.verbosity > 0)
+                printf("c |  Centrality time:      %12.2f s                                       |\n", centrality_time - parsed_time);
+            parsed_time = centrality_time;
+        }
+
         // Change to signal-handlers that will only notify the solver and allow it to terminate
         // voluntarily:
         signal(SIGINT, SIGINT_interrupt);
@@ -283,26 +327,101 @@ int main(int argc, char **argv)
             // float mut_rate = mutation_rate;
             printf("c |                                                                                                       |\n");
 
-            SAGA::GeneticAlgorithm *ga = new SAGA::GeneticAlgorithm(population_size, S.nVars(), max_generations, mutation_rate, crossover_rate, formula, S);
-            SAGA::Solution sol(ga->solve());
-            // bool symmetric = sol.is_symmetric(ga->getWorstSolution(), formula.generators);
-            // std::cout << "c |  Symmetric: " << symmetric << std::endl;
-            // exit(0);
-            // std::cout << sol.toString() << std::endl;
-
-            SAGA::initialize_polarity(sol, S);
-            double ga_time = cpuTime();
-            printf("c |  SAGA time:                           %12.2f s                                                  |\n", ga_time - initial_ga_time);
-            printf("c |  Best solution fitness:               %12d                                                    |\n", sol.getFitness());
-            // std::cout << "c |  SAGA time: " << std::setw(40) << std::fixed << std::setprecision(2) << (ga_time - initial_ga_time) << " s                 |\n";
-            // std::cout << "c |  Best solution fitness: " << std::setw(26) << sol.getFitness() << "                                                             |\n";
-            if (sol.getFitness() == 0)
+            // Extra SAGA ranks are forked here and leave once their islands are done
+            std::unique_ptr<SAGA::Gaspi::ShmContext> gaspi;
+            if (saga_background && saga_rephase > 0)
+                fprintf(stderr, "WARNING! -saga-rephase is ignored with -saga-background.\n");
+            if (saga_procs > 1 && saga_background)
+                fprintf(stderr, "WARNING! -saga-background runs a single SAGA process.\n");
+            else if (saga_procs > 1)
             {
-                // printf("c |  Solved by SAGA                                                                  |\n");
-                std::cout << "c |  Solved by SAGA                                                                       |\n";
+                gaspi.reset(new SAGA::Gaspi::ShmContext(saga_procs));
+                gaspi->start();
             }
-            printf("c |                                                                                                       |\n");
 
+            SAGA::GeneticAlgorithm *ga = new SAGA::GeneticAlgorithm(population_size, max_generations, mutation_rate, crossover_rate, formula, S);
+            ga->setIncremental(saga_incremental);
+            ga->setNumThreads(saga_threads);
+            ga->setBitsliced(saga_bitslice);
+            ga->setCacheCapacity(saga_cache);
+            ga->setOperators(saga_selection, saga_crossover, saga_mutation);
+            ga->setMutationPerChromosome(saga_mutation_chromosome);
+            ga->setSeed(saga_seed);
+            ga->setLocalSearch(saga_ls_steps, saga_ls_elite);
+            ga->setRepair(saga_repair);
+            ga->setInitialization(saga_init);
+            ga->setClauseWeighting(saga_weighting);
+            double time_budget = saga_time;
+            if (saga_time_frac > 0 && cpu_lim != INT32_MAX && (time_budget == 0 || saga_time_frac * cpu_lim < time_budget))
+                time_budget = saga_time_frac * cpu_lim;
+            ga->setTermination(time_budget, saga_stagnation);
+            ga->setIslands(saga_islands, saga_migration_interval, saga_migrants, saga_random_migration);
+            ga->setContext(gaspi.get());
+            if (saga_telemetry && (!gaspi || gaspi->rank() == 0))
+            {
+                // Only the islands of the first process are recorded, the others would share the file
+                telemetry.reset(new SAGA::Telemetry(saga_telemetry, saga_telemetry_format));
+                if (telemetry->ok())
+                    ga->setTelemetry(telemetry.get());
+                else
+                    fprintf(stderr, "WARNING! Could not open the SAGA telemetry file %s.\n", (const char *)saga_telemetry);
+            }
+            if (saga_background && !dimacs)
+            {
+                // The solver starts right away and adopts the best GA solution so far at every restart
+                phases.reset(new SAGA::PhaseExchange(ga->getGeneMap()));
+                ga->setPhaseExchange(phases.get());
+                S.phase_hook = phases.get();
+                background_ga = ga;
+                saga_thread = std::thread([ga]
+                                          { ga->solve(); });
+                printf("c |  SAGA running in the background on    %12d genes                                              |\n", (int)ga->getGeneMap().size() - 1);
+            }
+            else
+            {
+                SAGA::Solution sol(ga->solve());
+                if (gaspi && gaspi->rank() != 0)
+                    _exit(0);
+                if (gaspi)
+                    gaspi->join();
+                // bool symmetric = sol.is_symmetric(ga->getWorstSolution(), formula.generators);
+                // std::cout << "c |  Symmetric: " << symmetric << std::endl;
+                // exit(0);
+                // std::cout << sol.toString() << std::endl;
+
+                SAGA::initialize_polarity(sol, ga->getGeneMap(), S);
+                double ga_time = cpuTime();
+                printf("c |  SAGA time:                           %12.2f s                                                  |\n", ga_time - initial_ga_time);
+                printf("c |  Chromosome genes:                    %12d                                                    |\n", (int)ga->getGeneMap().size() - 1);
+                printf("c |  Best solution fitness:               %12d                                                    |\n", sol.getFitness());
+                if (saga_weighting > 0)
+                    printf("c |  Best solution raw fitness:           %12d                                                    |\n", ga->rawFitness(sol));
+                printf("c |  Generations:                         %12d                                                    |\n", ga->getGenerations());
+                printf("c |  Stop reason:                         %12s                                                    |\n", ga->getStopReasonName());
+                printf("c |  Fitness cache hits:                  %12" PRIu64 "                                                    |\n", ga->getCacheHits());
+                printf("c |  Fitness cache misses:                %12" PRIu64 "                                                    |\n", ga->getCacheMisses());
+                SAGA::EvaluationCounts evaluations = ga->getEvaluations();
+                printf("c |  Full evaluations:                    %12" PRIu64 "                                                    |\n", evaluations.full);
+                printf("c |  Delta evaluations:                   %12" PRIu64 "                                                    |\n", evaluations.delta);
+                printf("c |  Inherited fitness values:            %12" PRIu64 "                                                    |\n", evaluations.inherited);
+                // std::cout << "c |  SAGA time: " << std::setw(40) << std::fixed << std::setprecision(2) << (ga_time - initial_ga_time) << " s                 |\n";
+                // std::cout << "c |  Best solution fitness: " << std::setw(26) << sol.getFitness() << "                                                             |\n";
+                if (sol.getFitness() == 0)
+                {
+                    // printf("c |  Solved by SAGA                                                                  |\n");
+                    std::cout << "c |  Solved by SAGA                                                                       |\n";
+                }
+                printf("c |                                                                                                       |\n");
+
+                // The other ranks are gone, rephasing runs in this process only
+                if (saga_rephase > 0)
+                {
+                    ga->setContext(NULL);
+                    ga->setLearnts(saga_learnts, saga_learnt_weight);
+                    rephaser.reset(new SAGA::Rephaser(*ga, saga_rephase, saga_rephase_gens));
+                    S.phase_hook = rephaser.get();
+                }
+            }
             std::cout << "c =========================================================================================================\n";
         }
 
@@ -319,6 +438,19 @@ int main(int argc, char **argv)
         vec<Lit> dummy;
         lbool ret = S.solveLimited(dummy);
 
+        if (background_ga)
+        {
+            background_ga->interrupt();
+            saga_thread.join();
+            S.phase_hook = NULL;
+            if (S.verbosity > 0)
+                printf("c SAGA background: best fitness %d, %d generations, %" PRIu64 " phase updates, stop reason: %s\n",
+                       phases->getBestFitness(), background_ga->getGenerations(), phases->getUpdates(), background_ga->getStopReasonName());
+        }
+        if (rephaser && S.verbosity > 0)
+            printf("c SAGA rephasing: %" PRIu64 " rephases, last interval %d restarts, last budget %d generations, last raw fitness %d\n",
+                   rephaser->getRephases(), rephaser->getInterval(), rephaser->getGenerations(), rephaser->getRawFitness());
+
         if (S.verbosity > 0)
         {
             printStats(S);